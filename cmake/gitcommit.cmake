@@ -0,0 +1,23 @@
+# Writes OUTPUT defining ZHO_GIT_COMMIT as `git describe` of SOURCE_DIR.
+# Run on every build by the zho_git_commit target; the header is only
+# rewritten when the commit changes, so unchanged builds recompile nothing.
+set(commit "unknown")
+if (GIT_EXECUTABLE)
+    execute_process(COMMAND ${GIT_EXECUTABLE} describe --always --dirty
+            WORKING_DIRECTORY ${SOURCE_DIR}
+            OUTPUT_VARIABLE described
+            OUTPUT_STRIP_TRAILING_WHITESPACE
+            ERROR_QUIET
+            RESULT_VARIABLE result)
+    if (result EQUAL 0 AND described)
+        set(commit "${described}")
+    endif ()
+endif ()
+
+set(content "#define ZHO_GIT_COMMIT \"${commit}\"\n")
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} previous)
+endif ()
+if (NOT content STREQUAL previous)
+    file(WRITE ${OUTPUT} "${content}")
+endif ()
@@ -1,11 +1,102 @@
 #include "mainwindow.h"
 #include <QtWidgets/QApplication>
+#include <QFileInfo>
+#include <cstdio>
+#include <cstring>
+#include "calibration.h"
+#include "guibenchmark.h"
+#include "singleinstance.h"
+#include "startupprofiler.h"
+
+namespace {
+    constexpr int busy_instance_timeout_msec = 10000;
+}
 
 int main(int argc, char *argv[])
 {
+    startupMark("main");
+    // --gui-benchmark needs no display: it runs offscreen unless a
+    // platform is chosen, and with its own settings
+    bool gui_benchmark = false;
+    for (int i = 1; i < argc; ++i) {
+        gui_benchmark = gui_benchmark || std::strcmp(argv[i], "--gui-benchmark") == 0;
+    }
+    if (gui_benchmark && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
     QApplication a(argc, argv);
+    startupMark("application");
+    QApplication::setOrganizationName("laisuk");
+    QApplication::setApplicationName(gui_benchmark ? "ZhoConverterQt-benchmark" : "ZhoConverterQt");
+
+    // --new-instance skips the hand-off to an already running window;
+    // --startup-benchmark prints the start-up milestones once the converter
+    // is warm and exits; --gui-benchmark times the main window on large
+    // inputs once the converter is warm and exits; --recalibrate measures
+    // chunk size and thread count for this host again. Other options are
+    // ignored rather than opened as files; after "--" everything is a file.
+    QStringList files;
+    bool new_instance = false;
+    bool startup_benchmark = false;
+    bool recalibrate = false;
+    bool options_done = false;
+    for (const QString &argument: QApplication::arguments().mid(1)) {
+        if (options_done) {
+            files.append(QFileInfo(argument).absoluteFilePath());
+        } else if (argument == "--") {
+            options_done = true;
+        } else if (argument == "--new-instance") {
+            new_instance = true;
+        } else if (argument == "--startup-benchmark") {
+            new_instance = startup_benchmark = true;
+        } else if (argument == "--gui-benchmark") {
+            new_instance = true;
+        } else if (argument == "--recalibrate") {
+            new_instance = recalibrate = true;
+        } else if (argument.startsWith('-')) {
+            std::fprintf(stderr, "Ignoring unknown option %s\n", qPrintable(argument));
+        } else {
+            files.append(QFileInfo(argument).absoluteFilePath());
+        }
+    }
+    SingleInstance instance("ZhoConverterQt");
+    if (!new_instance) {
+        if (instance.sendToRunning(files)) {
+            return 0;
+        }
+        if (instance.listen() == SingleInstance::RunningElsewhere) {
+            // The running window is busy; give it longer before giving up
+            if (instance.sendToRunning(files, busy_instance_timeout_msec)) {
+                return 0;
+            }
+            std::fprintf(stderr, "ZhoConverterQt is already running but not responding\n");
+            return 1;
+        }
+    }
+
+    if (recalibrate) {
+        clearCalibration();
+    }
+
 	QApplication::setStyle("WindowsVista");
     MainWindow w;
+    startupMark("window built");
+    QObject::connect(&instance, &SingleInstance::argumentsReceived, &w, &MainWindow::openFiles);
+    if (startup_benchmark) {
+        QObject::connect(&w, &MainWindow::converterReady, &a, [&w] {
+            // Builds the Batch tab as its first showing would, to report
+            // what deferring it saves
+            w.showBatchTab();
+            std::fputs(qPrintable(startupReport()), stdout);
+            QApplication::quit();
+        });
+    }
+    if (gui_benchmark) {
+        QObject::connect(&w, &MainWindow::converterReady, &a, [&w] {
+            QApplication::exit(runGuiBenchmark(w, {}));
+        });
+    }
     w.show();
+    w.openFiles(files);
     return QApplication::exec();
 }
@@ -2,25 +2,337 @@
 #include "QClipboard"
 #include "QFileDialog"
 #include "QMessageBox"
+#include <QActionGroup>
+#include <QInputDialog>
+#include <QPointer>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
 #include <string>
-#include "opencc_fmmseg_capi.h"
 #include "zhoutilities.h"
-#include "draglistwidget.h"
+#include "batchpage.h"
+#include "folderwatcher.h"
+#include "convertermanager.h"
+#include "diagnosticsdialog.h"
+#include "cpusettingsdialog.h"
+#include "calibration.h"
+#include "metricsserver.h"
+#include "textnormalizer.h"
+#include "startupprofiler.h"
+#include "taskscheduler.h"
+#include "resultstore.h"
+#include "responsivenessmonitor.h"
+
+namespace {
+    // Configs warmed ahead of use, most used first
+    constexpr int preload_configs = 3;
+    // A converter unused for this long may be evicted under memory pressure
+    constexpr qint64 evict_idle_msec = 60 * 1000;
+    // Batch log lines are appended at most this often
+    constexpr int batch_log_msec = 100;
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindowClass()) {
     ui->setupUi(this);
     ui->tabWidget->setCurrentIndex(0);
+
+    // Map the manual configs ("s2t (简 -> 繁)", ...) to ZhoConfig once
+    for (int index = 0; index < ui->cbManual->count(); ++index) {
+        ZhoConfig config;
+        if (parseConfig(ui->cbManual->itemText(index).split(' ').first().toStdString(), config)) {
+            ui->cbManual->setItemData(index, static_cast<int>(config));
+        }
+    }
+
+    const QSettings settings;
+    // Event-loop stalls of this many ms or more are logged and listed in
+    // Help > Diagnostics (0: off)
+    ResponsivenessMonitor::instance().start(settings.value("monitor/stallMsec", 100).toInt());
+    ConverterManager::instance().restoreUsage(settings.value("converter/usage").toMap());
+    // One checkable action per registered backend; the choice applies
+    // before anything loads the converter
+    QString backend = settings.value("converter/backend", default_backend).toString();
+    if (!backendNames().contains(backend)) {
+        backend = default_backend;
+    }
+    ConverterManager::instance().setBackend(backend);
+    auto *backends = new QActionGroup(this);
+    for (const QString &name: backendNames()) {
+        QAction *action = ui->menuBackend->addAction(name);
+        action->setCheckable(true);
+        action->setChecked(name == backend);
+        backends->addAction(action);
+        connect(action, &QAction::triggered, this, [name] {
+            ConverterManager::instance().setBackend(name);
+            QSettings().setValue("converter/backend", name);
+        });
+    }
+    memoryBudgetMiB = settings.value("converter/memoryBudgetMiB", 0).toInt();
+    converterTimer.setInterval(15 * 1000);
+    connect(&converterTimer, &QTimer::timeout, this, &MainWindow::maintainConverter);
+    converterTimer.start();
+    // A line per finished file, appended as it comes, made small batches
+    // spend most of their time laying out the preview
+    batchLogTimer.setSingleShot(true);
+    batchLogTimer.setInterval(batch_log_msec);
+    connect(&batchLogTimer, &QTimer::timeout, this, &MainWindow::flushBatchLog);
+
+    threadCount = settings.value("batch/threads", 0).toInt();
+    CpuPlacement placement;
+    parseCpuList(settings.value("batch/cpus").toString(), placement.cpus);
+    placement.nice = settings.value("batch/nice", 0).toInt();
+    placement.preferPerformanceCores = settings.value("batch/performanceCores", false).toBool();
+    TaskScheduler::instance().setThreadCount(threadCount);
+    TaskScheduler::instance().setPlacement(placement);
+    if (const auto calibration = cachedCalibration()) {
+        applyCalibration(*calibration, threadCount > 0);
+    }
+    serveMetrics(settings.value("metrics/port", 0).toInt());
+
+    auto *punctuation_width = new QActionGroup(this);
+    for (QAction *action: {ui->actionPunctKeep, ui->actionPunctFull, ui->actionPunctHalf}) {
+        punctuation_width->addAction(action);
+    }
+    ui->actionNfc->setChecked(settings.value("normalize/nfc", false).toBool());
+    ui->actionFoldWidth->setChecked(settings.value("normalize/foldWidth", false).toBool());
+    ui->actionFoldVariants->setChecked(settings.value("normalize/foldVariants", false).toBool());
+    setVariantDirectory(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/variants");
+    const int width = settings.value("normalize/punctuationWidth", 0).toInt();
+    (width == 1 ? ui->actionPunctFull : width == 2 ? ui->actionPunctHalf : ui->actionPunctKeep)->setChecked(true);
+    applyNormalization();
+    for (const QAction *action: {ui->actionNfc, ui->actionFoldWidth, ui->actionFoldVariants, ui->actionPunctKeep,
+                                 ui->actionPunctFull, ui->actionPunctHalf}) {
+        connect(action, &QAction::toggled, this, &MainWindow::applyNormalization);
+    }
+
+    // Toggling the action applies the setting through its slot
+    ui->actionWorkerProcesses->setChecked(QSettings().value("batch/workerProcesses", false).toBool());
 }
 
 MainWindow::~MainWindow() {
+    if (estimateThread) {
+        estimateThread->wait();
+    }
+    ResponsivenessMonitor::instance().stop();
+    QSettings().setValue("converter/usage", ConverterManager::instance().usage());
     delete ui;
 }
 
+bool MainWindow::event(QEvent *event) {
+    const bool result = QMainWindow::event(event);
+    if (event->type() == QEvent::UpdateRequest && !firstPaintDone) {
+        firstPaintDone = true;
+        startupMark("first paint");
+        // Build the dictionaries off the GUI thread now that the window is
+        // up, so the first conversion does not pay for them.
+        TaskScheduler::instance().submit(TaskScheduler::Speculative, [self = QPointer<MainWindow>(this)] {
+            ConverterManager &manager = ConverterManager::instance();
+            const QStringList configs = manager.mostUsed(preload_configs);
+            manager.preload(configs.isEmpty() ? QStringList{"s2t"} : configs);
+            startupMark("converter ready");
+            QMetaObject::invokeMethod(qApp, [self] {
+                if (self) {
+                    emit self->converterReady();
+                    // Calibrate a new host once the warm-up no longer competes
+                    if (!cachedCalibration()) {
+                        self->startCalibration();
+                    }
+                }
+            }, Qt::QueuedConnection);
+        });
+    }
+    return result;
+}
+
+// Measures this host on a Background task. A running batch would compete
+// for the cores and skew the result, so the run waits for it to finish, and
+// is repeated if a batch starts meanwhile.
+void MainWindow::startCalibration() const {
+    if (batchConverter != nullptr && batchConverter->isRunning()) {
+        calibrationPending = true;
+        return;
+    }
+    calibrationPending = false;
+    calibrating = true;
+    calibrationDisturbed = false;
+    TaskScheduler::instance().submit(TaskScheduler::Background, [self = QPointer<const MainWindow>(this)] {
+        const Calibration calibration = calibrate();
+        QMetaObject::invokeMethod(qApp, [self, calibration] {
+            if (!self) {
+                return;
+            }
+            self->calibrating = false;
+            if (self->calibrationDisturbed) {
+                clearCalibration();
+                self->startCalibration();
+                return;
+            }
+            applyCalibration(calibration, self->threadCount > 0);
+        }, Qt::QueuedConnection);
+    });
+}
+
+// Evicts the converter when idle and memory is short, and preloads the most
+// used configs again once memory allows. Skipped while a batch is running.
+void MainWindow::maintainConverter() const {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
+    if (batchConverter != nullptr && batchConverter->isRunning()) {
+        return;
+    }
+    ConverterManager &manager = ConverterManager::instance();
+    const qint64 budget = static_cast<qint64>(memoryBudgetMiB) * 1024 * 1024;
+    if (manager.evictIfNeeded(budget, evict_idle_msec) || manager.isLoaded() || !manager.canPreload(budget)) {
+        return;
+    }
+    if (const QStringList configs = manager.mostUsed(preload_configs); !configs.isEmpty()) {
+        TaskScheduler::instance().submit(TaskScheduler::Background, [configs] {
+            ConverterManager::instance().preload(configs);
+        });
+    }
+}
+
+// The Batch tab's widgets are built the first time it is shown rather than
+// with the window; the time it takes is reported as deferred start-up work.
+BatchPage *MainWindow::batchTab() const {
+    if (batchPage == nullptr) {
+        const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
+        QElapsedTimer timer;
+        timer.start();
+        auto *self = const_cast<MainWindow *>(this);
+        batchPage = new BatchPage(ui->tabBatch);
+        ui->tabBatch->layout()->addWidget(batchPage);
+        connect(batchPage, &BatchPage::statusMessage, self, [self](const QString &message) {
+            self->ui->statusBar->showMessage(message);
+        });
+        connect(batchPage, &BatchPage::estimateRequested, self, &MainWindow::onEstimateRequested);
+        connect(batchPage, &BatchPage::watchToggled, self, &MainWindow::onWatchToggled);
+        startupDeferred("batch tab", static_cast<double>(timer.nsecsElapsed()) / 1e6);
+    }
+    return batchPage;
+}
+
+void MainWindow::showBatchTab() {
+    ui->tabWidget->setCurrentIndex(1);
+}
+
+// The batch engine owns thread pools; it is created on first batch use
+// rather than with the window.
+BatchConverter *MainWindow::batch() const {
+    if (batchConverter == nullptr) {
+        auto *self = const_cast<MainWindow *>(this);
+        batchConverter = new BatchConverter(self);
+        batchConverter->setWorkerProcesses(workerProcessCount);
+        connect(batchConverter, &BatchConverter::fileFinished, self, &MainWindow::onBatchFileFinished);
+        connect(batchConverter, &BatchConverter::finished, self, &MainWindow::onBatchFinished);
+    }
+    return batchConverter;
+}
+
 void MainWindow::on_btnExit_clicked() { this->close(); }
 
 void MainWindow::on_actionExit_triggered() { QApplication::quit(); }
 
+void MainWindow::on_actionWorkerProcesses_toggled(const bool checked) {
+    QSettings().setValue("batch/workerProcesses", checked);
+    workerProcessCount = checked ? (threadCount > 0 ? threadCount : QThread::idealThreadCount()) : 0;
+    if (batchConverter != nullptr) {
+        batchConverter->setWorkerProcesses(workerProcessCount);
+    }
+}
+
+void MainWindow::on_actionMemoryBudget_triggered() {
+    bool ok = false;
+    const int budget = QInputDialog::getInt(this, "Converter Memory Budget",
+                                            "Evict the idle converter above this resident size\n"
+                                            "(MiB, 0 = only under system memory pressure):",
+                                            memoryBudgetMiB, 0, 1024 * 1024, 64, &ok);
+    if (!ok) {
+        return;
+    }
+    memoryBudgetMiB = budget;
+    QSettings().setValue("converter/memoryBudgetMiB", budget);
+}
+
+void MainWindow::on_actionThreads_triggered() {
+    CpuSettingsDialog dialog(threadCount, TaskScheduler::instance().placement(), this);
+    if (dialog.exec() != QDialog::Accepted) {
+        return;
+    }
+    threadCount = dialog.threads();
+    const CpuPlacement placement = dialog.placement();
+    TaskScheduler::instance().setThreadCount(threadCount);
+    TaskScheduler::instance().setPlacement(placement);
+    if (const auto calibration = cachedCalibration(); calibration && threadCount == 0) {
+        applyCalibration(*calibration, false);
+    }
+
+    QSettings settings;
+    settings.setValue("batch/threads", threadCount);
+    settings.setValue("batch/cpus", formatCpuList(placement.cpus));
+    settings.setValue("batch/nice", placement.nice);
+    settings.setValue("batch/performanceCores", placement.preferPerformanceCores);
+    // Re-derive the worker process count from the new thread count
+    on_actionWorkerProcesses_toggled(ui->actionWorkerProcesses->isChecked());
+}
+
+void MainWindow::on_actionMetrics_triggered() {
+    bool ok = false;
+    const int port = QInputDialog::getInt(this, "Metrics Endpoint",
+                                          "Serve Prometheus metrics on http://localhost:<port>/metrics\n"
+                                          "(0 = off):",
+                                          metricsServer != nullptr && metricsServer->isListening()
+                                              ? metricsServer->port()
+                                              : 0, 0, 65535, 1, &ok);
+    if (!ok) {
+        return;
+    }
+    QSettings().setValue("metrics/port", port);
+    serveMetrics(port);
+}
+
+// Options > Input Normalization, for every conversion path
+void MainWindow::applyNormalization() const {
+    NormalizeOptions options;
+    options.nfc = ui->actionNfc->isChecked();
+    options.foldWidth = ui->actionFoldWidth->isChecked();
+    options.foldVariants = ui->actionFoldVariants->isChecked();
+    options.punctuationWidth = ui->actionPunctFull->isChecked()
+                                   ? PunctuationWidth::Full
+                                   : ui->actionPunctHalf->isChecked()
+                                         ? PunctuationWidth::Half
+                                         : PunctuationWidth::Keep;
+    setTextNormalization(options);
+
+    QSettings settings;
+    settings.setValue("normalize/nfc", options.nfc);
+    settings.setValue("normalize/foldWidth", options.foldWidth);
+    settings.setValue("normalize/foldVariants", options.foldVariants);
+    settings.setValue("normalize/punctuationWidth", static_cast<int>(options.punctuationWidth));
+}
+
+// Port 0 stops serving
+void MainWindow::serveMetrics(const int port) {
+    if (port <= 0 || port > 65535) {
+        if (metricsServer != nullptr) {
+            metricsServer->close();
+        }
+        return;
+    }
+    if (metricsServer == nullptr) {
+        metricsServer = new MetricsServer(this);
+    }
+    if (!metricsServer->listen(static_cast<quint16>(port))) {
+        ui->statusBar->showMessage(QString("Cannot serve metrics on port %1").arg(port));
+    }
+}
+
+void MainWindow::on_actionDiagnostics_triggered() {
+    DiagnosticsDialog dialog(this);
+    dialog.exec();
+}
+
 void MainWindow::on_actionAbout_triggered() {
     QMessageBox::about(this, "About",
                        "Zho Converter version 1.0.0 (c) 2024 Bryan Lai");
@@ -51,48 +363,26 @@ void MainWindow::update_tbSource_info(const int text_code) const {
     }
 }
 
-QString MainWindow::getCurrentConfig() const {
-    QString config;
+ZhoConfig MainWindow::getCurrentConfig() const {
     if (ui->rbManual->isChecked()) {
-        config = ui->cbManual->currentText().split(' ').first();
-    } else {
-        config =
-                ui->rbS2t->isChecked()
-                    ? (ui->rbStd->isChecked()
-                           ? "s2t"
-                           : (ui->rbHK->isChecked()
-                                  ? "s2hk"
-                                  : (ui->cbTWCN->isChecked()
-                                         ? "s2twp"
-                                         : "s2tw")))
-                    : (ui->rbStd->isChecked()
-                           ? "t2s"
-                           : (ui->rbHK->isChecked()
-                                  ? "t2hk"
-                                  : (ui->cbTWCN->isChecked()
-                                         ? "tw2sp"
-                                         : "tw2s")));
-    }
-    return config;
-}
-
-void MainWindow::displayFileList(const QStringList &files) const {
-    for (const QString &file: files) {
-        // Check if the file path is not already in the list box
-        if (!filePathExists(file)) {
-            ui->listSource->addItem(file);
-        }
+        return static_cast<ZhoConfig>(ui->cbManual->currentData().toInt());
     }
-}
-
-bool MainWindow::filePathExists(const QString &file_path) const {
-    // Check if the file path is already in the list box
-    for (int index = 0; index < ui->listSource->count(); ++index) {
-        if (const QListWidgetItem *item = ui->listSource->item(index); item && item->text() == file_path) {
-            return true;
+    if (ui->rbS2t->isChecked()) {
+        if (ui->rbStd->isChecked()) {
+            return ZhoConfig::S2t;
+        }
+        if (ui->rbHK->isChecked()) {
+            return ZhoConfig::S2hk;
         }
+        return ui->cbTWCN->isChecked() ? ZhoConfig::S2twp : ZhoConfig::S2tw;
+    }
+    if (ui->rbStd->isChecked()) {
+        return ZhoConfig::T2s;
+    }
+    if (ui->rbHK->isChecked()) {
+        return ZhoConfig::T2hk;
     }
-    return false;
+    return ui->cbTWCN->isChecked() ? ZhoConfig::Tw2sp : ZhoConfig::Tw2s;
 }
 
 void MainWindow::on_tabWidget_currentChanged(const int index) const {
@@ -102,6 +392,7 @@ void MainWindow::on_tabWidget_currentChanged(const int index) const {
             ui->btnSaveAs->setEnabled(true);
             break;
         case 1:
+            batchTab();
             ui->btnOpenFile->setEnabled(false);
             ui->btnSaveAs->setEnabled(false);
             break;
@@ -125,6 +416,7 @@ void MainWindow::on_cbTWCN_stateChanged(const int state) const {
 }
 
 void MainWindow::on_btnPaste_clicked() const {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
     if (QGuiApplication::clipboard()->text().isEmpty() ||
         QGuiApplication::clipboard()->text().isNull()) {
         ui->statusBar->showMessage("Clipboard empty");
@@ -142,17 +434,16 @@ void MainWindow::on_btnPaste_clicked() const {
         ui->statusBar->showMessage("Clipboard error.");
         return;
     }
-    const auto opencc = opencc_new();
-    const int text_code = opencc_zho_check(opencc, text.toUtf8());
+    const int text_code = ZhoCheck(text.toStdString());
     update_tbSource_info(text_code);
-    opencc_free(opencc);
 }
 
 void MainWindow::on_btnProcess_clicked() const {
-    const QString config = getCurrentConfig();
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
+    const ZhoConfig config = getCurrentConfig();
+    const QString config_name = configName(config);
     const bool is_punctuation = ui->cbPunctuation->isChecked();
-
-    const auto converter = opencc_new(); // Create converter
+    ConverterManager::instance().noteUsed(config_name);
 
     // Main Conversion
     if (ui->tabWidget->currentIndex() == 0) {
@@ -160,7 +451,6 @@ void MainWindow::on_btnProcess_clicked() const {
 
         if (input.isEmpty()) {
             ui->statusBar->showMessage("Source content is empty");
-            opencc_free(converter); // Close converter
             return;
         }
 
@@ -176,25 +466,41 @@ void MainWindow::on_btnProcess_clicked() const {
         }
 
 
-        const auto output = opencc_convert(converter, input.toUtf8(), config.toUtf8(), is_punctuation);
+        const QByteArray utf8 = input.toUtf8();
+        std::string text;
+        appendNormalized({utf8.constData(), static_cast<size_t>(utf8.size())}, textNormalization(config),
+                         text);
+        const ConverterLease converter = sharedConverter();
+        if (!converter) {
+            ui->statusBar->showMessage("Conversion failed: " + ConverterManager::instance().lastError());
+            return;
+        }
+        // Batch work pauses at its next chunk while this runs
+        bool converted = false;
+        const auto output = TaskScheduler::instance().runInteractive([&] {
+            const ResponsivenessMonitor::Activity conversion("MainWindow: interactive conversion");
+            return zhoConvert(converter.get(), text.c_str(), config, is_punctuation, &converted);
+        });
+        if (!converted) {
+            ui->statusBar->showMessage("Conversion failed. (" + config_name + ")");
+            return;
+        }
 
         ui->tbDestination->document()->clear();
         ui->tbDestination->document()->setPlainText(
             QString::fromStdString(output));
 
-        ui->statusBar->showMessage("Conversion process completed. (" + config + ")");
-        opencc_string_free(output); // delete char* output
+        ui->statusBar->showMessage("Conversion process completed. (" + config_name + ")");
     }
 
     // Batch Conversion
     if (ui->tabWidget->currentIndex() == 1) {
-        if (ui->listSource->count() == 0) {
+        if (batchTab()->files().isEmpty()) {
             ui->statusBar->showMessage("Nothing to convert: Empty file list.");
-            opencc_free(converter); // Close converter
             return;
         }
 
-        const QString out_dir = ui->lineEditDir->text();
+        const QString out_dir = batchTab()->outputDirectory();
         if (!QDir(out_dir).exists()) {
             QMessageBox msg;
             msg.setWindowTitle("Attention");
@@ -203,70 +509,40 @@ void MainWindow::on_btnProcess_clicked() const {
             msg.setInformativeText("Output directory:\n" + out_dir + "\n not found.");
             // msg.setDetailedText("Please set the required output directory.");
             msg.exec();
-            ui->lineEditDir->setFocus();
+            batchTab()->focusOutputDirectory();
             ui->statusBar->showMessage("Invalid output directory.");
-            opencc_free(converter);
             return;
         }
-        ui->tbPreview->clear();
-        for (int index = 0; index < ui->listSource->count(); index++) {
-            QString file_path = ui->listSource->item(index)->text();
-            QString output_file_name =
-                    out_dir + "/" + QFileInfo(file_path).fileName();
-            if (file_path == output_file_name) {
-                ui->tbPreview->appendPlainText(
-                    QString("%1: %2 --> Skip: Output Path = Source Path.")
-                    .arg(index + 1)
-                    .arg(output_file_name));
-                continue;
-            }
-            if (QFile(file_path).exists()) {
-                QFile input_file(file_path);
-                if (input_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                    QTextStream in(&input_file);
-                    QString input_text = in.readAll();
-                    input_file.close();
-
-                    const auto converted_text =
-                            opencc_convert(converter, input_text.toUtf8(), config.toUtf8(),
-                                           is_punctuation);
-
-                    std::string output_text = converted_text;
-
-                    opencc_string_free(converted_text); // Free up char* convertedText in loop
-
-                    QFile output_file(output_file_name);
-                    if (output_file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-                        QTextStream out(&output_file);
-                        out << QString::fromStdString(output_text);
-                        output_file.close();
-                        ui->tbPreview->appendPlainText(QString("%1: %2 --> Done.")
-                            .arg(index + 1)
-                            .arg(output_file_name));
-                    } else {
-                        ui->tbPreview->appendPlainText(
-                            QString("%1: %2 --> Error writing to file.")
-                            .arg(index + 1)
-                            .arg(output_file_name));
-                    }
-                } else {
-                    ui->tbPreview->appendPlainText(
-                        QString("%1: %2 --> Skip: Not text file.")
-                        .arg(index + 1)
-                        .arg(file_path));
-                }
-            } else {
-                ui->tbPreview->appendPlainText(QString("%1: %2 --> File not found.")
-                    .arg(index + 1)
-                    .arg(file_path));
-            }
+        batchTab()->preview()->clear();
+        batchLog.clear();
+        const QList<BatchConverter::Job> jobs = batchJobs();
+        if (batchEstimate && (batchEstimate->files != jobs.size() || batchEstimate->config != config)) {
+            batchEstimate.reset();
         }
-        ui->statusBar->showMessage("Process completed");
+        batchTimer.start();
+        batchConfig = config;
+        batchFiles = jobs.size();
+        batchInputBytes = 0;
+        batchOutputBytes = 0;
+        calibrationDisturbed = calibrationDisturbed || calibrating;
+        batch()->start(jobs, config, is_punctuation);
+        ui->statusBar->showMessage("Process started (" + config_name + ")");
     }
-    opencc_free(converter); // Close converter
 } // on_btnProcess_clicked
 
+QList<BatchConverter::Job> MainWindow::batchJobs() const {
+    const QString out_dir = batchTab()->outputDirectory();
+    const QStringList files = batchTab()->files();
+    QList<BatchConverter::Job> jobs;
+    jobs.reserve(files.size());
+    for (const QString &file_path: files) {
+        jobs.append({file_path, out_dir + "/" + QFileInfo(file_path).fileName()});
+    }
+    return jobs;
+}
+
 void MainWindow::on_btnCopy_clicked() const {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
     if (ui->tbDestination->document()->isEmpty()) {
         ui->statusBar->showMessage("Destination content empty.");
         return;
@@ -292,6 +568,11 @@ void MainWindow::on_btnOpenFile_clicked() {
     if (file_name.isEmpty())
         return;
 
+    loadSourceFile(file_name);
+}
+
+void MainWindow::loadSourceFile(const QString &file_name) const {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
     QFile file(file_name);
 
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
@@ -308,7 +589,25 @@ void MainWindow::on_btnOpenFile_clicked() {
     update_tbSource_info(text_code);
 }
 
+void MainWindow::openFiles(const QStringList &files) {
+    // A single file goes to the main tab, several to the batch list
+    if (files.size() == 1) {
+        ui->tabWidget->setCurrentIndex(0);
+        loadSourceFile(files.first());
+    } else if (!files.isEmpty()) {
+        showBatchTab();
+        batchTab()->addFiles(files);
+        ui->statusBar->showMessage("File(s) added.");
+    }
+    if (isMinimized()) {
+        showNormal();
+    }
+    raise();
+    activateWindow();
+}
+
 void MainWindow::on_btnSaveAs_clicked() {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
     const auto filename =
             QFileDialog::getSaveFileName(this, tr("Save Text File"), "./File.txt",
                                          tr("Text File (*.txt);;All Files (*.*)"));
@@ -329,6 +628,7 @@ void MainWindow::on_btnSaveAs_clicked() {
 }
 
 void MainWindow::on_btnRefresh_clicked() const {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
     if (ui->tbSource->toPlainText().isEmpty()) {
         return;
     }
@@ -337,90 +637,190 @@ void MainWindow::on_btnRefresh_clicked() const {
 }
 
 void MainWindow::on_tbSource_textChanged() const {
+    // Runs on every key press: count without copying the document (its
+    // count includes one final paragraph separator)
     ui->lblCharCount->setText(
-        QStringLiteral("[ %L1 chars ]").arg(ui->tbSource->document()->toPlainText().length()));
-}
-
-void MainWindow::on_btnAdd_clicked() {
-    QFileDialog file_dialog(this);
-    file_dialog.setFileMode(QFileDialog::ExistingFiles);
-
-    if (const QStringList files =
-            QFileDialog::getOpenFileNames(this,
-                                          "Open Files",
-                                          "",
-                                          "Text Files (*.txt);;"
-                                          "Subtitle Files (*.srt *.vtt *.ass *.ttml2 *.xml));;"
-                                          "XML Files (*.xml *.ttml2);;"
-                                          "All Files (*.*)"); !files.isEmpty()) {
-        displayFileList(files);
-        ui->statusBar->showMessage("File(s) added.");
-    }
+        QStringLiteral("[ %L1 chars ]").arg(ui->tbSource->document()->characterCount() - 1));
 }
 
-void MainWindow::on_btnRemove_clicked() const {
-    if (QList<QListWidgetItem *> selected_items = ui->listSource->selectedItems(); !selected_items.isEmpty()) {
-        for (const QListWidgetItem *selected_item: selected_items) {
-            const int row = ui->listSource->row(selected_item);
-            ui->listSource->takeItem(row);
-            delete selected_item; // Ensure to delete the item to free up memory
-        }
-        ui->statusBar->showMessage("File(s) removed.");
-    }
+void MainWindow::on_btnClearTbSource_clicked() const {
+    ui->tbSource->clear();
+    ui->lblSourceCode->setText("");
+    ui->lblFileName->setText("");
+    ui->statusBar->showMessage("Source contents cleared");
 }
 
-void MainWindow::on_btnListClear_clicked() const {
-    ui->listSource->clear();
-    ui->statusBar->showMessage("All entries cleared.");
+void MainWindow::on_btnClearTbDestination_clicked() const {
+    ui->tbDestination->clear();
+    ui->lblDestinationCode->setText("");
+    ui->statusBar->showMessage("Destination contents cleared");
 }
 
-void MainWindow::on_btnPreview_clicked() const {
-    if (QList<QListWidgetItem *> selected_items = ui->listSource->selectedItems(); !selected_items.isEmpty()) {
-        const QListWidgetItem *selected_item = selected_items[0];
-        const QString file_path = selected_item->text();
+void MainWindow::on_cbManual_activated() const {
+    ui->rbManual->setChecked(true);
+}
 
-        QFile file(file_path);
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QTextStream in(&file);
-            const QString contents = in.readAll();
-            file.close();
-            ui->tbPreview->setPlainText(contents);
-            ui->statusBar->showMessage("Preview: " + file_path);
-        } else {
-            ui->tbPreview->clear();
-            ui->statusBar->showMessage(file_path + ": Not a valid text file.");
+void MainWindow::onWatchToggled(const bool checked) {
+    if (!checked) {
+        if (folderWatcher != nullptr) {
+            folderWatcher->stop();
         }
+        ui->statusBar->showMessage("Folder watch stopped.");
+        return;
+    }
+
+    QPushButton *watch_button = batchTab()->watchButton();
+    const QSignalBlocker blocker(watch_button);
+    const QString out_dir = QDir(batchTab()->outputDirectory()).absolutePath();
+    if (!QDir(out_dir).exists()) {
+        watch_button->setChecked(false);
+        batchTab()->focusOutputDirectory();
+        ui->statusBar->showMessage("Invalid output directory.");
+        return;
+    }
+
+    const QString watch_dir = QFileDialog::getExistingDirectory(this, "Select folder to watch");
+    if (watch_dir.isEmpty()) {
+        watch_button->setChecked(false);
+        return;
     }
+    if (const QString watch_path = QDir(watch_dir).absolutePath();
+        out_dir == watch_path || out_dir.startsWith(watch_path + "/")) {
+        watch_button->setChecked(false);
+        ui->statusBar->showMessage("Output directory must not be inside the watched folder.");
+        return;
+    }
+    if (folderWatcher == nullptr) {
+        folderWatcher = new FolderWatcher(this);
+        connect(folderWatcher, &FolderWatcher::filesReady, this, &MainWindow::onWatchFilesReady);
+    }
+    if (!folderWatcher->start(watch_dir)) {
+        watch_button->setChecked(false);
+        ui->statusBar->showMessage("Cannot watch folder: " + watch_dir);
+        return;
+    }
+    ui->statusBar->showMessage("Watching: " + folderWatcher->directory());
+}
+
+void MainWindow::onEstimateRequested() {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
+    const QList<BatchConverter::Job> jobs = batchJobs();
+    if (jobs.isEmpty()) {
+        ui->statusBar->showMessage("Nothing to estimate: Empty file list.");
+        return;
+    }
+    const ZhoConfig config = getCurrentConfig();
+    const bool is_punctuation = ui->cbPunctuation->isChecked();
+    const int threads = workerProcessCount > 0 ? workerProcessCount : TaskScheduler::instance().threadCount();
+    batchTab()->estimateButton()->setEnabled(false);
+    ui->statusBar->showMessage("Estimating batch ...");
+
+    // Off the GUI thread, and off the pool whose tasks the estimate waits for
+    estimateThread = QThread::create([self = QPointer<MainWindow>(this), jobs, config, is_punctuation, threads] {
+        const BatchEstimate estimate = estimateBatch(jobs, config, is_punctuation, threads);
+        QMetaObject::invokeMethod(qApp, [self, estimate] {
+            if (self) {
+                self->showEstimate(estimate);
+            }
+        }, Qt::QueuedConnection);
+    });
+    estimateThread->setParent(this);
+    connect(estimateThread, &QThread::finished, estimateThread, &QObject::deleteLater);
+    estimateThread->start();
 }
 
-void MainWindow::on_btnOutDir_clicked() {
-    QFileDialog file_dialog(this);
-    file_dialog.setFileMode(QFileDialog::Directory);
+void MainWindow::showEstimate(const BatchEstimate &estimate) {
+    batchEstimate = estimate;
+    batchTab()->estimateButton()->setEnabled(true);
+    batchTab()->preview()->setPlainText(formatEstimate(estimate));
+    ui->statusBar->showMessage(QString("Estimated %1 s for %2 files").arg(estimate.seconds, 0, 'f', 1)
+        .arg(estimate.files));
+}
 
-    if (const QString directory = QFileDialog::getExistingDirectory(this, ""); !directory.isEmpty()) {
-        ui->lineEditDir->setText(directory);
-        ui->statusBar->showMessage("Output directory set: " + directory);
+void MainWindow::onBatchFileFinished(const int index, const QString &input, const QString &output,
+                                     const BatchConverter::Status status) const {
+    switch (status) {
+        case BatchConverter::Done:
+            batchInputBytes += QFileInfo(input).size();
+            batchOutputBytes += QFileInfo(output).size();
+            appendBatchLog(QString("%1: %2 --> Done.").arg(index + 1).arg(output));
+            break;
+        case BatchConverter::SkipSamePath:
+            appendBatchLog(QString("%1: %2 --> Skip: Output Path = Source Path.").arg(index + 1).arg(output));
+            break;
+        case BatchConverter::NotText:
+            appendBatchLog(QString("%1: %2 --> Skip: Not text file.").arg(index + 1).arg(input));
+            break;
+        case BatchConverter::NotFound:
+            appendBatchLog(QString("%1: %2 --> File not found.").arg(index + 1).arg(input));
+            break;
+        case BatchConverter::WriteError:
+            appendBatchLog(QString("%1: %2 --> Error writing to file.").arg(index + 1).arg(output));
+            break;
+        case BatchConverter::WorkerFailed:
+            appendBatchLog(QString("%1: %2 --> Skip: Worker crashed or timed out.").arg(index + 1).arg(input));
+            break;
+        case BatchConverter::ConvertError:
+            appendBatchLog(QString("%1: %2 --> Conversion failed.").arg(index + 1).arg(input));
+            break;
     }
 }
 
-void MainWindow::on_btnPreviewClear_clicked() const {
-    ui->tbPreview->clear();
-    ui->statusBar->showMessage("Preview contents cleared");
+void MainWindow::appendBatchLog(const QString &line) const {
+    batchLog.append(line);
+    if (!batchLogTimer.isActive()) {
+        batchLogTimer.start();
+    }
 }
 
-void MainWindow::on_btnClearTbSource_clicked() const {
-    ui->tbSource->clear();
-    ui->lblSourceCode->setText("");
-    ui->lblFileName->setText("");
-    ui->statusBar->showMessage("Source contents cleared");
+void MainWindow::flushBatchLog() const {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
+    batchLogTimer.stop();
+    if (!batchLog.isEmpty()) {
+        batchTab()->preview()->appendPlainText(batchLog.join('\n'));
+        batchLog.clear();
+    }
 }
 
-void MainWindow::on_btnClearTbDestination_clicked() const {
-    ui->tbDestination->clear();
-    ui->lblDestinationCode->setText("");
-    ui->statusBar->showMessage("Destination contents cleared");
+void MainWindow::onBatchFinished() const {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
+    flushBatchLog();
+    const double seconds = static_cast<double>(batchTimer.elapsed()) / 1000;
+    if (batchEstimate) {
+        batchTab()->preview()->appendPlainText(recordBatchResult(*batchEstimate, seconds, batchOutputBytes));
+        batchEstimate.reset();
+    }
+    if (batchInputBytes > 0) {
+        appendResult("batch", "gui", batchConfig, batchWorkload(batchFiles, batchInputBytes),
+                     static_cast<double>(batchInputBytes) / 1e6 / std::max(seconds, 1e-3));
+    }
+    if (folderWatcher != nullptr && folderWatcher->isActive()) {
+        ui->statusBar->showMessage("Watching: " + folderWatcher->directory());
+    } else {
+        ui->statusBar->showMessage("Process completed");
+    }
+    if (calibrationPending) {
+        startCalibration();
+    }
 }
 
-void MainWindow::on_cbManual_activated() const {
-    ui->rbManual->setChecked(true);
+void MainWindow::onWatchFilesReady(const QStringList &files) const {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
+    batchEstimate.reset();
+    const QString out_dir = batchTab()->outputDirectory();
+    const QDir watch_dir(folderWatcher->directory());
+
+    QList<BatchConverter::Job> jobs;
+    jobs.reserve(files.size());
+    for (const QString &file_path: files) {
+        // Mirror the watched tree below the output directory
+        jobs.append({file_path, out_dir + "/" + watch_dir.relativeFilePath(file_path)});
+    }
+    batchTimer.start();
+    batchConfig = getCurrentConfig();
+    batchFiles = jobs.size();
+    batchInputBytes = 0;
+    batchOutputBytes = 0;
+    calibrationDisturbed = calibrationDisturbed || calibrating;
+    batch()->start(jobs, batchConfig, ui->cbPunctuation->isChecked());
 }
@@ -1,12 +1,23 @@
 #pragma once
 
 #include <QtWidgets/QMainWindow>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QThread>
+#include <QTimer>
+#include <optional>
 #include "ui_mainwindow.h"
+#include "batchconverter.h"
+#include "batchplanner.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindowClass; };
 QT_END_NAMESPACE
 
+class BatchPage;
+class FolderWatcher;
+class MetricsServer;
+
 class MainWindow final : public QMainWindow
 {
     Q_OBJECT
@@ -15,12 +26,34 @@ public:
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow() override;
 
+signals:
+    // Emitted once the converter has been warmed up after the first paint.
+    void converterReady();
+
+public slots:
+    // Opens files passed on the command line or handed over by a second
+    // launch, and brings the window to the front.
+    void openFiles(const QStringList &files);
+
+    // Switches to the Batch tab, building it on first use.
+    void showBatchTab();
+
 private slots:
 
     void on_btnExit_clicked();
 
     static void on_actionExit_triggered();
 
+    void on_actionWorkerProcesses_toggled(bool checked);
+
+    void on_actionMemoryBudget_triggered();
+
+    void on_actionThreads_triggered();
+
+    void on_actionMetrics_triggered();
+
+    void on_actionDiagnostics_triggered();
+
     void on_actionAbout_triggered();
 
 	void on_tabWidget_currentChanged(int index) const;
@@ -47,30 +80,70 @@ private slots:
 
 	void on_tbSource_textChanged() const;
 
-	void on_btnAdd_clicked();
+    void on_btnClearTbSource_clicked() const;
 
-	void on_btnRemove_clicked() const;
+    void on_btnClearTbDestination_clicked() const;
 
-	void on_btnListClear_clicked() const;
+    void on_cbManual_activated() const;
 
-	void on_btnPreview_clicked() const;
+    void onWatchToggled(bool checked);
 
-	void on_btnOutDir_clicked();
+    void onEstimateRequested();
 
-	void on_btnPreviewClear_clicked() const;
+    void onBatchFileFinished(int index, const QString &input, const QString &output,
+                             BatchConverter::Status status) const;
 
-    void on_btnClearTbSource_clicked() const;
+    void onBatchFinished() const;
 
-    void on_btnClearTbDestination_clicked() const;
+    void onWatchFilesReady(const QStringList &files) const;
 
-    void on_cbManual_activated() const;
+protected:
+    bool event(QEvent *event) override;
 
 private:
     Ui::MainWindowClass *ui;
-
-	void displayFileList(const QStringList& files) const;
-	bool filePathExists(const QString& file_path) const;
+    mutable BatchPage *batchPage = nullptr;
+    mutable BatchConverter *batchConverter = nullptr;
+    FolderWatcher *folderWatcher = nullptr;
+    MetricsServer *metricsServer = nullptr;
+    int workerProcessCount = 0;
+    int threadCount = 0;
+    int memoryBudgetMiB = 0;
+    bool firstPaintDone = false;
+    QTimer converterTimer;
+    // Running estimate, waited for on destruction
+    QPointer<QThread> estimateThread;
+    // Estimate of the batch about to run, compared with it when it finishes
+    mutable std::optional<BatchEstimate> batchEstimate;
+    mutable QElapsedTimer batchTimer;
+    mutable ZhoConfig batchConfig = ZhoConfig::S2t;
+    mutable qsizetype batchFiles = 0;
+    mutable qint64 batchInputBytes = 0;
+    mutable qint64 batchOutputBytes = 0;
+    // Batch log lines waiting to be appended to the preview in one go
+    mutable QStringList batchLog;
+    mutable QTimer batchLogTimer;
+    // Host calibration: waiting for the running batch to end, running, and
+    // whether a batch started during the run (which skews it)
+    mutable bool calibrationPending = false;
+    mutable bool calibrating = false;
+    mutable bool calibrationDisturbed = false;
+
+    BatchPage *batchTab() const;
+    BatchConverter *batch() const;
+    QList<BatchConverter::Job> batchJobs() const;
+
+    void appendBatchLog(const QString &line) const;
+
+    void flushBatchLog() const;
+    void showEstimate(const BatchEstimate &estimate);
+    void serveMetrics(int port);
+    void applyNormalization() const;
+    void maintainConverter() const;
+    void startCalibration() const;
+
+	void loadSourceFile(const QString& file_name) const;
 	void update_tbSource_info(int text_code) const;
-	QString getCurrentConfig() const;
+	ZhoConfig getCurrentConfig() const;
 
 };
@@ -0,0 +1,101 @@
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "backendbenchmark.h"
+#include "batchconverter.h"
+#include "converterbackend.h"
+#include "convertermanager.h"
+#include "resultstore.h"
+
+namespace {
+    const std::string sample_line = u8"简体中文转换为繁体中文，这是一个测试句子。計算機軟體與頭髮的轉換。\n";
+    constexpr size_t corpus_size = 16 * 1024 * 1024;
+    // Batch row: texts of a typical small file
+    constexpr size_t batch_text_size = 2048;
+    constexpr size_t check_text_size = 64 * 1024;
+
+    QString capabilityNames(const int capabilities) {
+        QStringList names;
+        if (capabilities & IConverterBackend::Punctuation) {
+            names << "punctuation";
+        }
+        if (capabilities & IConverterBackend::Check) {
+            names << "check";
+        }
+        if (capabilities & IConverterBackend::Batch) {
+            names << "batch";
+        }
+        return names.isEmpty() ? QStringLiteral("none") : names.join(", ");
+    }
+
+    template<typename Run>
+    double megabytesPerSecond(const size_t bytes, Run run) {
+        QElapsedTimer timer;
+        timer.start();
+        run();
+        return static_cast<double>(bytes) / 1e6 / std::max(static_cast<double>(timer.nsecsElapsed()) / 1e9, 1e-9);
+    }
+}
+
+int runBackendBenchmark(const ZhoConfig config) {
+    std::string corpus;
+    while (corpus.size() + sample_line.size() <= corpus_size) {
+        corpus += sample_line;
+    }
+    std::string batch_text;
+    while (batch_text.size() + sample_line.size() <= batch_text_size) {
+        batch_text += sample_line;
+    }
+    const std::vector<std::string> batch(corpus.size() / batch_text.size(), batch_text);
+    const std::string check_text = corpus.substr(0, check_text_size);
+
+    std::printf("Corpus %.1f MB, config %s, %d chunk bytes\n", static_cast<double>(corpus.size()) / 1e6,
+                configName(config), static_cast<int>(BatchConverter::chunkSize()));
+    std::printf("%-16s %9s %9s %9s %9s %9s %9s  %s\n", "backend", "load ms", "MiB", "whole", "chunked", "batch",
+                "check", "capabilities (throughput in MB/s)");
+    int failed = 0;
+    for (const QString &name: backendNames()) {
+        QString error;
+        QElapsedTimer timer;
+        timer.start();
+        const qint64 before = ConverterManager::residentBytes();
+        const std::unique_ptr<IConverterBackend> backend = createBackend(name, error);
+        if (backend == nullptr) {
+            std::printf("%-16s %s\n", qPrintable(name), qPrintable(error));
+            ++failed;
+            continue;
+        }
+        const double load_msec = static_cast<double>(timer.nsecsElapsed()) / 1e6;
+        const double mebibytes = static_cast<double>(std::max<qint64>(0, ConverterManager::residentBytes() - before)) /
+                                 (1024 * 1024);
+        const int capabilities = backend->capabilities();
+
+        const double whole = megabytesPerSecond(corpus.size(), [&] {
+            zhoConvert(backend.get(), corpus.c_str(), config, false);
+        });
+        std::string chunked_output;
+        const double chunked = megabytesPerSecond(corpus.size(), [&] {
+            BatchConverter::convertText(backend.get(), corpus, config, false, chunked_output);
+        });
+        const double batched = megabytesPerSecond(batch.size() * batch_text.size(), [&] {
+            backend->convertBatch(batch, config, false);
+        });
+        const double check = capabilities & IConverterBackend::Check
+                                 ? megabytesPerSecond(check_text.size() * 100, [&] {
+                                     for (int i = 0; i < 100; ++i) {
+                                         backend->check(check_text.c_str());
+                                     }
+                                 })
+                                 : 0;
+        std::printf("%-16s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f  %s\n", qPrintable(name), load_msec, mebibytes, whole,
+                    chunked, batched, check, qPrintable(capabilityNames(capabilities)));
+        const QString corpus_workload = fileWorkload(1, static_cast<qint64>(corpus.size()));
+        appendResult("bench-backends", name + ", whole", config, corpus_workload, whole);
+        appendResult("bench-backends", name + ", chunked", config, corpus_workload, chunked);
+        appendResult("bench-backends", name + ", batch", config,
+                     fileWorkload(static_cast<qint64>(batch.size()), static_cast<qint64>(batch_text.size())), batched);
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,12 @@
+#ifndef BACKENDBENCHMARK_H
+#define BACKENDBENCHMARK_H
+
+#include "zhoconfig.h"
+
+// Loads every registered converter backend side by side and prints, per
+// backend, its capabilities, load time and memory, and the throughput of
+// whole-text, chunked (as batch files convert) and batch conversion with
+// config and of script detection, on a generated 16 MiB corpus.
+int runBackendBenchmark(ZhoConfig config);
+
+#endif // BACKENDBENCHMARK_H
@@ -0,0 +1,376 @@
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSemaphore>
+#include <QSet>
+#include <QTextStream>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "batchconverter.h"
+#include "compressedio.h"
+#include "convertermanager.h"
+#include "filewriter.h"
+#include "metrics.h"
+#include "streamconverter.h"
+#include "taskscheduler.h"
+#include "textnormalizer.h"
+#include "uringbatchio.h"
+#include "workerpool.h"
+#include "zhoutilities.h"
+
+namespace {
+    FILE *openFile(const QString &path, const bool write) {
+#ifdef Q_OS_WIN
+        return _wfopen(reinterpret_cast<const wchar_t *>(path.utf16()), write ? L"wb" : L"rb");
+#else
+        return std::fopen(QFile::encodeName(path).constData(), write ? "wb" : "rb");
+#endif
+    }
+
+    // Files above the chunk size are converted in pieces with a scheduler
+    // yield point between them, so interactive work never waits behind a
+    // whole file.
+    std::atomic<size_t> batch_chunk_size{BatchConverter::default_chunk_size};
+
+    // Compressed files larger than this get their own decompress / compress
+    // threads; for small ones the extra threads cost more than they overlap.
+    constexpr qint64 pipeline_threshold = 4 * 1024 * 1024;
+
+    BatchConverter::Status convertCompressedFile(const IConverterBackend *converter, const QString &input,
+                                                 const QString &output, const ZhoConfig config,
+                                                 const bool punctuation) {
+        FILE *input_file = openFile(input, false);
+        if (input_file == nullptr) {
+            return BatchConverter::NotText;
+        }
+        QDir().mkpath(QFileInfo(output).absolutePath());
+        FILE *output_file = openFile(output, true);
+        if (output_file == nullptr) {
+            std::fclose(input_file);
+            return BatchConverter::WriteError;
+        }
+
+        const auto source = makeSource(input_file);
+        const auto sink = makeSink(output_file, compressionFromName(output.toStdString()));
+        StreamConverter stream(converter, config, punctuation);
+        std::string error;
+        const bool pipelined = QFileInfo(input).size() >= pipeline_threshold;
+        const bool completed = pumpStream(*source, *sink, stream, pipelined, error);
+
+        dropPageCache(fileno(input_file));
+        std::fclose(input_file);
+        if (std::fclose(output_file) != 0 || !completed) {
+            return stream.failed()
+                       ? BatchConverter::ConvertError
+                       : source->failed()
+                             ? BatchConverter::NotText
+                             : BatchConverter::WriteError;
+        }
+        return BatchConverter::Done;
+    }
+
+    // Appends the conversion to output; false when the converter fails.
+    // fixed_chunk_size 0: the process-wide setting, read per chunk so a new
+    // calibration applies to running batches
+    bool convertInChunks(const IConverterBackend *converter, std::string_view text, const ZhoConfig config,
+                         const bool punctuation, std::string &output, const size_t fixed_chunk_size = 0) {
+        output.reserve(output.size() + text.size() + text.size() / 8);
+        const NormalizeOptions normalize = textNormalization(config);
+        NormalizeState normalize_state;
+        std::string piece;
+        while (!text.empty()) {
+            const size_t chunk_size = fixed_chunk_size != 0
+                                          ? fixed_chunk_size
+                                          : batch_chunk_size.load(std::memory_order_relaxed);
+            // A run of stray continuation bytes has no boundary; cut it anyway
+            size_t boundary = find_split_boundary(text, chunk_size);
+            if (boundary == 0) {
+                boundary = std::min(text.size(), chunk_size);
+            }
+            piece.clear();
+            appendNormalized(text.substr(0, boundary), normalize, piece, &normalize_state);
+            if (boundary == text.size()) {
+                finishNormalized(normalize_state, piece);
+            }
+            const size_t start = output.size();
+            if (!converter->convert(piece.c_str(), config, punctuation, output)) {
+                return false;
+            }
+            Metrics::addConversion(piece.size(), output.data() + start, output.size() - start);
+            text.remove_prefix(boundary);
+            TaskScheduler::yieldPoint();
+        }
+        return true;
+    }
+}
+
+BatchConverter::BatchConverter(QObject *parent) : QObject(parent) {
+    qRegisterMetaType<BatchConverter::Status>("BatchConverter::Status");
+    // One I/O thread drives the ring; batches queue behind each other.
+    ioPool.setMaxThreadCount(1);
+}
+
+BatchConverter::~BatchConverter() {
+    // Queued tasks see the flag and return at once; the I/O thread may be
+    // waiting for them, so the pool must not be cleared under it.
+    cancelled = true;
+    ioPool.waitForDone();
+    tasks.wait();
+}
+
+void BatchConverter::start(const QList<Job> &jobs, const ZhoConfig config, const bool punctuation) {
+    if (jobs.isEmpty()) {
+        return;
+    }
+    cancelled = false;
+    pending += static_cast<int>(jobs.size());
+
+    if (processCount > 0) {
+        if (workerPool == nullptr) {
+            workerPool = new WorkerPool(this);
+            connect(workerPool, &WorkerPool::fileFinished, this,
+                    [this](const int index, const QString &input, const QString &output, const Status status) {
+                        finishJob(index, {input, output}, status);
+                    });
+        }
+        workerPool->setWorkerCount(processCount);
+        if (workerPool->isAvailable()) {
+            workerPool->start(jobs, config, punctuation);
+            return;
+        }
+        qWarning("Worker executable %s not found; converting in threads", qPrintable(workerPool->program()));
+    }
+
+    if (backend == UringIo && isIoBackendAvailable(UringIo)) {
+        ioPool.start([this, jobs, config, punctuation] {
+            runUringBatch(jobs, config, punctuation);
+        });
+        return;
+    }
+
+    for (int index = 0; index < jobs.size(); ++index) {
+        const Job job = jobs.at(index);
+        TaskScheduler::instance().submit(TaskScheduler::Batch, [this, index, job, config, punctuation] {
+            if (cancelled) {
+                releaseJob();
+                return;
+            }
+            QElapsedTimer timer;
+            timer.start();
+            // Null when the backend fails to load
+            const ConverterLease converter = sharedConverter();
+            const Status status = converter ? convertFile(converter.get(), job.input, job.output, config, punctuation)
+                                            : ConvertError;
+            Metrics::observeFile(config, timer.nsecsElapsed());
+            finishJob(index, job, status);
+        }, &tasks);
+    }
+}
+
+void BatchConverter::finishJob(const int index, const Job &job, const Status status) {
+    Metrics::addFile(status);
+    if (!cancelled) {
+        emit fileFinished(index, job.input, job.output, status);
+    }
+    releaseJob();
+}
+
+void BatchConverter::releaseJob() {
+    if (--pending == 0) {
+        emit finished();
+    }
+}
+
+void BatchConverter::runUringBatch(const QList<Job> &jobs, const ZhoConfig config, const bool punctuation) {
+    thread_local UringBatchIO io;
+    const int depth = static_cast<int>(io.depth());
+
+    // Reads the batch starting at offset. Jobs the ring cannot handle keep a
+    // non-zero error and go through convertFile() instead.
+    const auto read_batch = [&](const int offset, std::vector<UringReadResult> &results) {
+        std::vector<std::string> paths;
+        const int count = std::min(depth, static_cast<int>(jobs.size()) - offset);
+        for (int i = 0; i < count; ++i) {
+            paths.push_back(QFile::encodeName(jobs.at(offset + i).input).toStdString());
+        }
+        io.readBatch(paths, results);
+    };
+
+    std::vector<UringReadResult> current;
+    std::vector<UringReadResult> next;
+    read_batch(0, current);
+
+    for (int offset = 0; offset < jobs.size(); offset += depth) {
+        const int count = static_cast<int>(current.size());
+        std::vector<Status> statuses(count, Done);
+        std::vector<std::string> outputs(count);
+        // Written from the conversion tasks, so not vector<bool>
+        std::vector<char> converted(count, false);
+        std::vector<char> skipped(count, false);
+
+        QSemaphore done;
+        for (int i = 0; i < count; ++i) {
+            TaskScheduler::instance().submit(TaskScheduler::Batch, [&, i] {
+                QElapsedTimer timer;
+                timer.start();
+                const Job &job = jobs.at(offset + i);
+                UringReadResult &read = current[i];
+                std::string_view text = read.data;
+                // Same normalisation as the QTextStream path: drop the BOM,
+                // and leave invalid UTF-8 to its replacement handling.
+                if (text.substr(0, 3) == "\xEF\xBB\xBF") {
+                    text.remove_prefix(3);
+                }
+                if (cancelled) {
+                    skipped[i] = true;
+                    done.release();
+                    return;
+                }
+                const ConverterLease converter = sharedConverter();
+                if (job.input == job.output) {
+                    statuses[i] = SkipSamePath;
+                } else if (!converter) {
+                    statuses[i] = ConvertError;
+                } else if (read.error != 0 || compressionFromName(job.input.toStdString()) != Compression::None ||
+                           !is_valid_utf8(text)) {
+                    statuses[i] = convertFile(converter.get(), job.input, job.output, config, punctuation);
+                } else if (convertInChunks(converter.get(), text, config, punctuation, outputs[i])) {
+                    converted[i] = true;
+                } else {
+                    statuses[i] = ConvertError;
+                }
+                Metrics::observeFile(config, timer.nsecsElapsed());
+                done.release();
+            }, &tasks);
+        }
+
+        // Overlap reading the next batch with converting this one
+        if (offset + depth < jobs.size()) {
+            read_batch(offset + depth, next);
+        }
+        done.acquire(count);
+
+        std::vector<UringWriteRequest> writes;
+        std::vector<int> write_index;
+        QSet<QString> output_dirs;
+        for (int i = 0; i < count; ++i) {
+            if (converted[i]) {
+                const QString &output = jobs.at(offset + i).output;
+                output_dirs.insert(QFileInfo(output).absolutePath());
+                writes.push_back({QFile::encodeName(output).toStdString(), outputs[i]});
+                write_index.push_back(i);
+            }
+        }
+        for (const QString &dir: std::as_const(output_dirs)) {
+            QDir().mkpath(dir);
+        }
+        std::vector<int> errors;
+        io.writeBatch(writes, errors);
+        for (size_t w = 0; w < writes.size(); ++w) {
+            // Writes the ring gave up on, or never took, use the standard path
+            if (errors[w] == -ECANCELED || errors[w] == -EINVAL) {
+                errors[w] = writeWholeFile(jobs.at(offset + write_index[w]).output, writes[w].data) ? 0 : -EIO;
+            }
+            if (errors[w] != 0) {
+                statuses[write_index[w]] = WriteError;
+            }
+        }
+
+        for (int i = 0; i < count; ++i) {
+            if (skipped[i]) {
+                releaseJob();
+            } else {
+                finishJob(offset + i, jobs.at(offset + i), statuses[i]);
+            }
+        }
+        std::swap(current, next);
+    }
+}
+
+bool BatchConverter::isRunning() const {
+    return pending > 0;
+}
+
+void BatchConverter::setIoBackend(const IoBackend io_backend) {
+    backend = io_backend;
+}
+
+BatchConverter::IoBackend BatchConverter::ioBackend() const {
+    return backend;
+}
+
+bool BatchConverter::isIoBackendAvailable(const IoBackend io_backend) {
+    if (io_backend == UringIo) {
+        static const bool supported = UringBatchIO::isSupported();
+        return supported;
+    }
+    return true;
+}
+
+void BatchConverter::setWorkerProcesses(const int count) {
+    processCount = std::max(0, count);
+}
+
+int BatchConverter::workerProcesses() const {
+    return processCount;
+}
+
+void BatchConverter::setChunkSize(const size_t size) {
+    batch_chunk_size = std::max<size_t>(size, 4096);
+}
+
+size_t BatchConverter::chunkSize() {
+    return batch_chunk_size;
+}
+
+bool BatchConverter::convertText(const IConverterBackend *converter, const std::string_view text,
+                                 const ZhoConfig config, const bool punctuation, std::string &out,
+                                 const size_t chunk_size) {
+    return convertInChunks(converter, text, config, punctuation, out, chunk_size);
+}
+
+void BatchConverter::waitForDone() {
+    ioPool.waitForDone();
+    tasks.wait();
+}
+
+BatchConverter::Status BatchConverter::convertFile(const IConverterBackend *converter, const QString &input,
+                                                   const QString &output, const ZhoConfig config,
+                                                   const bool punctuation) {
+    if (input == output) {
+        return SkipSamePath;
+    }
+    if (!QFile(input).exists()) {
+        return NotFound;
+    }
+    if (compressionFromName(input.toStdString()) != Compression::None) {
+        return convertCompressedFile(converter, input, output, config, punctuation);
+    }
+
+    QFile input_file(input);
+    if (!input_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return NotText;
+    }
+    QTextStream in(&input_file);
+    const QString input_text = in.readAll();
+    // Batch inputs are read once; keep them from crowding the page cache
+    dropPageCache(input_file.handle());
+    input_file.close();
+
+    const QByteArray text = input_text.toUtf8();
+    std::string converted_text;
+    if (!convertInChunks(converter, std::string_view(text.constData(), text.size()), config, punctuation,
+                         converted_text)) {
+        return ConvertError;
+    }
+
+    QDir().mkpath(QFileInfo(output).absolutePath());
+    return writeWholeFile(output, converted_text) ? Done : WriteError;
+}
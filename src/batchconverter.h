@@ -0,0 +1,116 @@
+#ifndef BATCHCONVERTER_H
+#define BATCHCONVERTER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QList>
+#include <atomic>
+#include <string>
+#include <string_view>
+#include "converterbackend.h"
+#include "taskscheduler.h"
+#include "zhoconfig.h"
+
+class WorkerPool;
+
+// Converts files as Batch tasks on the shared TaskScheduler pool. Large files
+// are converted in chunks with yield points in between. All threads share
+// the process-wide opencc instance (see ConverterManager).
+class BatchConverter : public QObject {
+Q_OBJECT
+
+public:
+    enum Status {
+        Done,
+        SkipSamePath,
+        NotText,
+        NotFound,
+        WriteError,
+        WorkerFailed,
+        ConvertError // the converter failed on the text
+    };
+
+    Q_ENUM(Status)
+
+    enum IoBackend {
+        StandardIo,
+        UringIo
+    };
+
+    Q_ENUM(IoBackend)
+
+    struct Job {
+        QString input;
+        QString output;
+    };
+
+    explicit BatchConverter(QObject *parent = nullptr);
+
+    ~BatchConverter() override;
+
+    // Queues the jobs and returns immediately. May be called again while a
+    // previous batch is still running; finished() is emitted once all queued
+    // jobs are done.
+    void start(const QList<Job> &jobs, ZhoConfig config, bool punctuation);
+
+    bool isRunning() const;
+
+    // UringIo is used only when compiled in and supported by the running
+    // kernel; otherwise start() silently uses StandardIo.
+    void setIoBackend(IoBackend io_backend);
+
+    IoBackend ioBackend() const;
+
+    static bool isIoBackendAvailable(IoBackend io_backend);
+
+    // With count > 0, files are converted in that many `zhoconv --worker`
+    // processes instead of pool threads (see WorkerPool), so a crash or hang
+    // only loses the file being converted. Falls back to threads when the
+    // worker executable is missing. 0 (the default) uses threads.
+    void setWorkerProcesses(int count);
+
+    int workerProcesses() const;
+
+    void waitForDone();
+
+    // Size of the pieces large files are converted in, process-wide. Set
+    // from the host calibration (see calibration.h).
+    static constexpr size_t default_chunk_size = 256 * 1024;
+
+    static void setChunkSize(size_t size);
+
+    static size_t chunkSize();
+
+    static Status convertFile(const IConverterBackend *converter, const QString &input, const QString &output,
+                              ZhoConfig config, bool punctuation);
+
+    // The chunked in-memory conversion convertFile() uses for plain files,
+    // in pieces of chunk_size bytes (0: chunkSize()), appended to out.
+    // Returns false when the converter fails.
+    static bool convertText(const IConverterBackend *converter, std::string_view text, ZhoConfig config,
+                            bool punctuation, std::string &out, size_t chunk_size = 0);
+
+signals:
+    void fileFinished(int index, const QString &input, const QString &output, BatchConverter::Status status);
+
+    void finished();
+
+private:
+    void runUringBatch(const QList<Job> &jobs, ZhoConfig config, bool punctuation);
+
+    void finishJob(int index, const Job &job, Status status);
+
+    // Ends a job skipped because the converter is being destroyed; it
+    // counts in no file metric.
+    void releaseJob();
+
+    TaskScheduler::Group tasks;
+    QThreadPool ioPool;
+    WorkerPool *workerPool = nullptr;
+    int processCount = 0;
+    IoBackend backend = StandardIo;
+    std::atomic<int> pending{0};
+    std::atomic<bool> cancelled{false};
+};
+
+#endif // BATCHCONVERTER_H
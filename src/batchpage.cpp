@@ -0,0 +1,126 @@
+#include <QFile>
+#include <QFileDialog>
+#include <QTextStream>
+#include "batchpage.h"
+#include "responsivenessmonitor.h"
+#include "ui_batchpage.h"
+
+BatchPage::BatchPage(QWidget *parent) : QWidget(parent), ui(new Ui::BatchPage()) {
+    ui->setupUi(this);
+    connect(ui->btnEstimate, &QPushButton::clicked, this, &BatchPage::estimateRequested);
+    connect(ui->btnWatch, &QPushButton::toggled, this, &BatchPage::watchToggled);
+}
+
+BatchPage::~BatchPage() {
+    delete ui;
+}
+
+void BatchPage::addFiles(const QStringList &files) const {
+    for (const QString &file: files) {
+        // Check if the file path is not already in the list box
+        if (!filePathExists(file)) {
+            ui->listSource->addItem(file);
+        }
+    }
+}
+
+QStringList BatchPage::files() const {
+    QStringList files;
+    files.reserve(ui->listSource->count());
+    for (int index = 0; index < ui->listSource->count(); index++) {
+        files.append(ui->listSource->item(index)->text());
+    }
+    return files;
+}
+
+QString BatchPage::outputDirectory() const {
+    return ui->lineEditDir->text();
+}
+
+void BatchPage::focusOutputDirectory() const {
+    ui->lineEditDir->setFocus();
+}
+
+QPlainTextEdit *BatchPage::preview() const {
+    return ui->tbPreview;
+}
+
+QPushButton *BatchPage::estimateButton() const {
+    return ui->btnEstimate;
+}
+
+QPushButton *BatchPage::watchButton() const {
+    return ui->btnWatch;
+}
+
+bool BatchPage::filePathExists(const QString &file_path) const {
+    // Check if the file path is already in the list box
+    for (int index = 0; index < ui->listSource->count(); ++index) {
+        if (const QListWidgetItem *item = ui->listSource->item(index); item && item->text() == file_path) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BatchPage::on_btnAdd_clicked() {
+    if (const QStringList files =
+            QFileDialog::getOpenFileNames(this,
+                                          "Open Files",
+                                          "",
+                                          "Text Files (*.txt);;"
+                                          "Subtitle Files (*.srt *.vtt *.ass *.ttml2 *.xml));;"
+                                          "XML Files (*.xml *.ttml2);;"
+                                          "All Files (*.*)"); !files.isEmpty()) {
+        addFiles(files);
+        emit statusMessage("File(s) added.");
+    }
+}
+
+void BatchPage::on_btnRemove_clicked() {
+    if (QList<QListWidgetItem *> selected_items = ui->listSource->selectedItems(); !selected_items.isEmpty()) {
+        for (const QListWidgetItem *selected_item: selected_items) {
+            const int row = ui->listSource->row(selected_item);
+            ui->listSource->takeItem(row);
+            delete selected_item; // Ensure to delete the item to free up memory
+        }
+        emit statusMessage("File(s) removed.");
+    }
+}
+
+void BatchPage::on_btnListClear_clicked() {
+    ui->listSource->clear();
+    emit statusMessage("All entries cleared.");
+}
+
+void BatchPage::on_btnPreview_clicked() {
+    const ResponsivenessMonitor::Activity activity(Q_FUNC_INFO);
+    if (QList<QListWidgetItem *> selected_items = ui->listSource->selectedItems(); !selected_items.isEmpty()) {
+        const QListWidgetItem *selected_item = selected_items[0];
+        const QString file_path = selected_item->text();
+
+        QFile file(file_path);
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QTextStream in(&file);
+            const QString contents = in.readAll();
+            file.close();
+            ui->tbPreview->setPlainText(contents);
+            emit statusMessage("Preview: " + file_path);
+        } else {
+            ui->tbPreview->clear();
+            emit statusMessage(file_path + ": Not a valid text file.");
+        }
+    }
+}
+
+void BatchPage::on_btnOutDir_clicked() {
+    if (const QString directory = QFileDialog::getExistingDirectory(this, ""); !directory.isEmpty()) {
+        ui->lineEditDir->setText(directory);
+        emit statusMessage("Output directory set: " + directory);
+    }
+}
+
+void BatchPage::on_btnPreviewClear_clicked() {
+    ui->tbPreview->clear();
+    emit statusMessage("Preview contents cleared");
+}
@@ -0,0 +1,65 @@
+#ifndef BATCHPAGE_H
+#define BATCHPAGE_H
+
+#include <QWidget>
+
+QT_BEGIN_NAMESPACE
+namespace Ui { class BatchPage; }
+QT_END_NAMESPACE
+
+class QPlainTextEdit;
+class QPushButton;
+
+// The Batch tab: the file list, the preview box (which also shows the batch
+// log and estimates) and the output directory. MainWindow builds it the
+// first time the tab is shown, so start-up does not pay for its widgets.
+class BatchPage final : public QWidget {
+Q_OBJECT
+
+public:
+    explicit BatchPage(QWidget *parent = nullptr);
+
+    ~BatchPage() override;
+
+    // Adds the files not yet in the list.
+    void addFiles(const QStringList &files) const;
+
+    QStringList files() const;
+
+    QString outputDirectory() const;
+
+    void focusOutputDirectory() const;
+
+    QPlainTextEdit *preview() const;
+
+    QPushButton *estimateButton() const;
+
+    QPushButton *watchButton() const;
+
+signals:
+    void statusMessage(const QString &message);
+
+    void estimateRequested();
+
+    void watchToggled(bool checked);
+
+private slots:
+    void on_btnAdd_clicked();
+
+    void on_btnRemove_clicked();
+
+    void on_btnListClear_clicked();
+
+    void on_btnPreview_clicked();
+
+    void on_btnOutDir_clicked();
+
+    void on_btnPreviewClear_clicked();
+
+private:
+    bool filePathExists(const QString &file_path) const;
+
+    Ui::BatchPage *ui;
+};
+
+#endif // BATCHPAGE_H
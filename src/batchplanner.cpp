@@ -0,0 +1,237 @@
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include "batchplanner.h"
+#include "compressedio.h"
+#include "convertermanager.h"
+#include "taskscheduler.h"
+#include "zhoutilities.h"
+
+namespace {
+    enum Kind {
+        Cjk,
+        Latin,
+        Compressed,
+        Skipped
+    };
+
+    constexpr int kind_count = Skipped;
+
+    struct Input {
+        qint64 size = 0;
+        Kind kind = Skipped;
+    };
+
+    struct Rate {
+        double bytesPerSecond = 0; // input bytes, one thread
+        double outputRatio = 1;
+    };
+
+    // Head read to classify an input
+    constexpr qint64 sniff_bytes = 4096;
+    // Prefix converted per sampled input, and inputs sampled per kind
+    constexpr size_t sample_bytes = 1024 * 1024;
+    constexpr int samples_per_kind = 2;
+    // Used when no input of a kind could be sampled
+    constexpr double fallback_bytes_per_second = 20e6;
+    // Decompressed size of compressed inputs, which are not sampled
+    constexpr double compressed_expansion = 3;
+    // A plain input is held as file text, QString, UTF-8 copy and output at
+    // once; compressed inputs stream through a few blocks.
+    constexpr double plain_memory_factor = 4.5;
+    constexpr qint64 compressed_memory_bytes = 8 * 1024 * 1024;
+    // Weight of the newest run in the learned correction
+    constexpr double correction_weight = 0.3;
+
+    Input sniff(const BatchConverter::Job &job) {
+        Input input;
+        const QFileInfo info(job.input);
+        if (job.input == job.output || !info.isFile()) {
+            return input;
+        }
+        input.size = info.size();
+        if (compressionFromName(job.input.toStdString()) != Compression::None) {
+            input.kind = Compressed;
+            return input;
+        }
+        QFile file(job.input);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return input;
+        }
+        const QByteArray head = file.read(sniff_bytes);
+        const std::string_view text(head.constData(), find_max_utf8_length({head.constData(),
+                                                                             static_cast<size_t>(head.size())},
+                                                                            head.size()));
+        if (!is_valid_utf8(text)) {
+            return input;
+        }
+        const auto multibyte = std::count_if(text.begin(), text.end(), [](const char c) {
+            return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+        });
+        input.kind = multibyte * 4 >= static_cast<qsizetype>(text.size()) ? Cjk : Latin;
+        return input;
+    }
+
+    // Converts a prefix of path and returns its rate, or a zero rate.
+    Rate sample(const IConverterBackend *converter, const QString &path, const ZhoConfig config,
+                const bool punctuation) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return {};
+        }
+        const QByteArray head = file.read(sample_bytes);
+        const size_t length = find_split_boundary({head.constData(), static_cast<size_t>(head.size())},
+                                                  sample_bytes);
+        if (length == 0) {
+            return {};
+        }
+        const std::string text(head.constData(), length);
+        QElapsedTimer timer;
+        timer.start();
+        const size_t output_size = zhoConvert(converter, text.c_str(), config, punctuation).size();
+        const double seconds = static_cast<double>(timer.nsecsElapsed()) / 1e9;
+        return {static_cast<double>(length) / std::max(seconds, 1e-6),
+                static_cast<double>(output_size) / static_cast<double>(length)};
+    }
+
+    QString settingsKey(const ZhoConfig config) {
+        return QStringLiteral("planner/%1/correction").arg(configName(config));
+    }
+
+    QString mebibytes(const qint64 bytes) {
+        return QStringLiteral("%1 MiB").arg(static_cast<double>(bytes) / (1024 * 1024), 0, 'f', 1);
+    }
+}
+
+BatchEstimate estimateBatch(const QList<BatchConverter::Job> &jobs, const ZhoConfig config, const bool punctuation,
+                            const int threads) {
+    BatchEstimate estimate;
+    estimate.config = config;
+    estimate.threads = std::max(1, threads);
+    estimate.files = static_cast<int>(jobs.size());
+
+    // Stat and sniff in parallel; one task per slice keeps task overhead
+    // negligible for large lists.
+    std::vector<Input> inputs(jobs.size());
+    std::atomic<qint64> sniff_nsecs{0};
+    TaskScheduler::Group group;
+    const qsizetype slice = std::max<qsizetype>(64, jobs.size() / (4 * estimate.threads));
+    for (qsizetype begin = 0; begin < jobs.size(); begin += slice) {
+        const qsizetype end = std::min(begin + slice, jobs.size());
+        TaskScheduler::instance().submit(TaskScheduler::Interactive, [&, begin, end] {
+            QElapsedTimer timer;
+            timer.start();
+            for (qsizetype i = begin; i < end; ++i) {
+                inputs[i] = sniff(jobs.at(i));
+            }
+            sniff_nsecs += timer.nsecsElapsed();
+        }, &group);
+    }
+    group.wait();
+    // Opening, reading and writing a file costs roughly twice the sniff
+    const double per_file_seconds = jobs.isEmpty() ? 0 : 2.0 * static_cast<double>(sniff_nsecs) / 1e9 / jobs.size();
+
+    // Sample the largest inputs of each kind
+    std::vector<Rate> rates(kind_count);
+    const ConverterLease converter = sharedConverter();
+    for (int kind = Cjk; kind <= Latin; ++kind) {
+        std::vector<qsizetype> candidates;
+        for (qsizetype i = 0; i < jobs.size(); ++i) {
+            if (inputs[i].kind == kind) {
+                candidates.push_back(i);
+            }
+        }
+        const size_t count = std::min<size_t>(samples_per_kind, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(count),
+                          candidates.end(), [&](const qsizetype a, const qsizetype b) {
+                              return inputs[a].size > inputs[b].size;
+                          });
+        double total_rate = 0;
+        double total_ratio = 0;
+        int sampled = 0;
+        for (size_t i = 0; i < count && converter; ++i) {
+            if (const Rate rate = sample(converter.get(), jobs.at(candidates[i]).input, config, punctuation);
+                rate.bytesPerSecond > 0) {
+                total_rate += rate.bytesPerSecond;
+                total_ratio += rate.outputRatio;
+                ++sampled;
+            }
+        }
+        if (sampled > 0) {
+            rates[kind] = {total_rate / sampled, total_ratio / sampled};
+        }
+    }
+    for (Rate &rate: rates) {
+        if (rate.bytesPerSecond == 0) {
+            rate = rates[Cjk].bytesPerSecond > 0 ? rates[Cjk] : rates[Latin];
+        }
+        if (rate.bytesPerSecond == 0) {
+            rate = {fallback_bytes_per_second, 1};
+        }
+    }
+    rates[Compressed].outputRatio *= compressed_expansion;
+
+    // Files run whole on one thread each: the batch takes its share of the
+    // total work, but no less than its longest file.
+    double work = 0;
+    double longest = 0;
+    std::vector<qint64> in_flight;
+    for (const Input &input: inputs) {
+        if (input.kind == Skipped) {
+            ++estimate.skippedFiles;
+            continue;
+        }
+        ++estimate.textFiles;
+        const Rate &rate = rates[input.kind];
+        const double expansion = input.kind == Compressed ? compressed_expansion : 1;
+        const double seconds = per_file_seconds + input.size * expansion / rate.bytesPerSecond;
+        work += seconds;
+        longest = std::max(longest, seconds);
+        estimate.inputBytes += input.size;
+        estimate.outputBytes += static_cast<qint64>(input.size * rate.outputRatio);
+        in_flight.push_back(input.kind == Compressed
+                                ? compressed_memory_bytes
+                                : static_cast<qint64>(input.size * plain_memory_factor));
+    }
+    estimate.correction = QSettings().value(settingsKey(config), 1.0).toDouble();
+    estimate.seconds = std::max(work / estimate.threads, longest) * estimate.correction;
+
+    const size_t parallel = std::min<size_t>(estimate.threads, in_flight.size());
+    std::partial_sort(in_flight.begin(), in_flight.begin() + static_cast<std::ptrdiff_t>(parallel), in_flight.end(),
+                      std::greater<>());
+    estimate.peakMemoryBytes = ConverterManager::residentBytes();
+    for (size_t i = 0; i < parallel; ++i) {
+        estimate.peakMemoryBytes += in_flight[i];
+    }
+    return estimate;
+}
+
+QString recordBatchResult(const BatchEstimate &estimate, const double seconds, const qint64 output_bytes) {
+    const double predicted = estimate.seconds / estimate.correction;
+    if (predicted > 0 && seconds > 0) {
+        // Clamp so one disturbed run (cold cache, machine busy) cannot
+        // throw later estimates far off.
+        const double error = std::clamp(seconds / predicted, 0.1, 10.0);
+        const double correction = (1 - correction_weight) * estimate.correction + correction_weight * error;
+        QSettings().setValue(settingsKey(estimate.config), correction);
+    }
+    return QStringLiteral("Estimated %1 s / %2, took %3 s / %4")
+            .arg(estimate.seconds, 0, 'f', 1).arg(mebibytes(estimate.outputBytes))
+            .arg(seconds, 0, 'f', 1).arg(mebibytes(output_bytes));
+}
+
+QString formatEstimate(const BatchEstimate &estimate) {
+    return QStringLiteral("%1 files (%2 text, %3 skipped), %4 in, config %5, %6 threads\n"
+                "Estimated time:   %7 s\n"
+                "Estimated output: %8\n"
+                "Estimated memory: %9 peak")
+            .arg(estimate.files).arg(estimate.textFiles).arg(estimate.skippedFiles)
+            .arg(mebibytes(estimate.inputBytes)).arg(configName(estimate.config)).arg(estimate.threads)
+            .arg(estimate.seconds, 0, 'f', 1).arg(mebibytes(estimate.outputBytes))
+            .arg(mebibytes(estimate.peakMemoryBytes));
+}
@@ -0,0 +1,37 @@
+#ifndef BATCHPLANNER_H
+#define BATCHPLANNER_H
+
+#include <QString>
+#include "batchconverter.h"
+
+// Prediction for one batch before it runs.
+struct BatchEstimate {
+    ZhoConfig config = ZhoConfig::S2t;
+    int threads = 0;
+    int files = 0;       // jobs
+    int textFiles = 0;   // plain or compressed text
+    int skippedFiles = 0; // missing, same path or not text
+    qint64 inputBytes = 0;
+    qint64 outputBytes = 0;
+    qint64 peakMemoryBytes = 0;
+    double seconds = 0;
+    double correction = 1; // learned actual / predicted time applied above
+};
+
+// Dry run of a batch: stats every input on the pool and sniffs its first
+// bytes (CJK text, mostly Latin text, compressed, not text), converts a
+// prefix of a few inputs of each kind to measure throughput and output
+// growth, and predicts wall time for `threads` parallel files, output size,
+// and peak memory (converter plus the largest files in flight at once).
+// Loads the shared converter if it is not loaded yet.
+BatchEstimate estimateBatch(const QList<BatchConverter::Job> &jobs, ZhoConfig config, bool punctuation,
+                            int threads);
+
+// Folds the error of a finished batch into the per-config correction kept in
+// QSettings, so later estimates on this host come closer. Returns a one-line
+// comparison for the log.
+QString recordBatchResult(const BatchEstimate &estimate, double seconds, qint64 output_bytes);
+
+QString formatEstimate(const BatchEstimate &estimate);
+
+#endif // BATCHPLANNER_H
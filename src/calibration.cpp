@@ -0,0 +1,177 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QSettings>
+#include <QSysInfo>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "calibration.h"
+#include "batchconverter.h"
+#include "convertermanager.h"
+#include "cpuplacement.h"
+#include "taskscheduler.h"
+#include "zhoutilities.h"
+
+namespace {
+    const char *const corpus_lines[] = {
+        u8"简体中文转换为繁体中文，这是一个测试句子。\n",
+        u8"软件开发人员在服务器上部署了新的数据库系统。\n",
+        u8"Mixed 中英文 text with numbers 2024 and 标点符号！\n",
+    };
+
+    constexpr size_t corpus_bytes = 4 * 1024 * 1024;
+    constexpr size_t chunk_candidates[] = {64 << 10, 128 << 10, 256 << 10, 512 << 10, 1 << 20, 4 << 20};
+    constexpr size_t thread_piece_bytes = 512 * 1024;
+    // Smaller chunks preempt sooner and fewer threads leave the machine
+    // usable, so they win unless clearly slower.
+    constexpr double chunk_tolerance = 0.97;
+    constexpr double thread_tolerance = 0.95;
+
+    std::string makeCorpus(const size_t size) {
+        std::string corpus;
+        corpus.reserve(size + 256);
+        for (size_t i = 0; corpus.size() < size; ++i) {
+            corpus += corpus_lines[i % std::size(corpus_lines)];
+        }
+        return corpus;
+    }
+
+    void convertCorpus(const IConverterBackend *converter, std::string_view text, const size_t chunk_size) {
+        std::string piece;
+        while (!text.empty()) {
+            const size_t boundary = find_split_boundary(text, chunk_size);
+            piece.assign(text.substr(0, boundary));
+            zhoConvert(converter, piece.c_str(), ZhoConfig::S2t, false);
+            text.remove_prefix(boundary);
+        }
+    }
+
+    double megabytesPerSecond(const size_t bytes, const QElapsedTimer &timer) {
+        return static_cast<double>(bytes) / 1e6 / std::max(static_cast<double>(timer.nsecsElapsed()) / 1e9, 1e-6);
+    }
+
+    // Cache group: host name plus CPU count. The settings file itself is
+    // shared by the GUI and zhoconv.
+    QString hostKey() {
+        return QStringLiteral("%1-%2").arg(QSysInfo::machineHostName()).arg(QThread::idealThreadCount());
+    }
+}
+
+std::optional<Calibration> cachedCalibration() {
+    QSettings settings(QCoreApplication::organizationName(), "calibration");
+    settings.beginGroup(hostKey());
+    if (!settings.contains("chunkSize")) {
+        return std::nullopt;
+    }
+    Calibration calibration;
+    calibration.chunkSize = settings.value("chunkSize").toULongLong();
+    calibration.threads = settings.value("threads").toInt();
+    calibration.mbPerSecond = settings.value("mbPerSecond").toDouble();
+    calibration.measured = settings.value("measured").toDateTime();
+    calibration.results = settings.value("results").toStringList();
+    return calibration;
+}
+
+Calibration calibrate() {
+    Calibration calibration;
+    const ConverterLease converter = sharedConverter();
+    if (!converter) {
+        return calibration;
+    }
+    const std::string corpus = makeCorpus(corpus_bytes);
+
+    // Chunk size: one thread, the whole corpus per candidate
+    double best = 0;
+    std::vector<double> rates;
+    for (const size_t chunk: chunk_candidates) {
+        QElapsedTimer timer;
+        timer.start();
+        convertCorpus(converter.get(), corpus, chunk);
+        rates.push_back(megabytesPerSecond(corpus.size(), timer));
+        best = std::max(best, rates.back());
+        calibration.results.append(QStringLiteral("chunk %1 KiB: %2 MB/s").arg(chunk / 1024, 5)
+            .arg(rates.back(), 7, 'f', 1));
+    }
+    for (size_t i = 0; i < rates.size(); ++i) {
+        if (rates[i] >= best * chunk_tolerance) {
+            calibration.chunkSize = chunk_candidates[i];
+            break;
+        }
+    }
+
+    // Thread count: the same pieces spread over pools of different sizes
+    const int ideal = QThread::idealThreadCount();
+    QList<int> candidates{std::max(1, ideal / 2), std::max(1, ideal * 3 / 4), ideal};
+    if (const CpuTopology &topology = cpuTopology(); topology.isHybrid()) {
+        candidates.append(static_cast<int>(topology.performance.size()));
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    const std::string_view piece(corpus.data(), find_split_boundary(corpus, thread_piece_bytes));
+    const int pieces = 2 * ideal;
+    best = 0;
+    rates.clear();
+    for (const int threads: candidates) {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < pieces; ++i) {
+            pool.start([&] { convertCorpus(converter.get(), piece, calibration.chunkSize); });
+        }
+        pool.waitForDone();
+        rates.push_back(megabytesPerSecond(piece.size() * pieces, timer));
+        best = std::max(best, rates.back());
+        calibration.results.append(QStringLiteral("threads %1: %2 MB/s").arg(threads, 5)
+            .arg(rates.back(), 7, 'f', 1));
+    }
+    for (qsizetype i = 0; i < candidates.size(); ++i) {
+        if (rates[i] >= best * thread_tolerance) {
+            calibration.threads = candidates[i];
+            calibration.mbPerSecond = rates[i];
+            break;
+        }
+    }
+    calibration.measured = QDateTime::currentDateTime();
+
+    QSettings settings(QCoreApplication::organizationName(), "calibration");
+    settings.beginGroup(hostKey());
+    settings.setValue("chunkSize", static_cast<qulonglong>(calibration.chunkSize));
+    settings.setValue("threads", calibration.threads);
+    settings.setValue("mbPerSecond", calibration.mbPerSecond);
+    settings.setValue("measured", calibration.measured);
+    settings.setValue("results", calibration.results);
+    return calibration;
+}
+
+void clearCalibration() {
+    QSettings settings(QCoreApplication::organizationName(), "calibration");
+    settings.remove(hostKey());
+}
+
+void applyCalibration(const Calibration &calibration, const bool keep_threads) {
+    if (calibration.chunkSize > 0) {
+        BatchConverter::setChunkSize(calibration.chunkSize);
+    }
+    if (!keep_threads && calibration.threads > 0) {
+        TaskScheduler::instance().setThreadCount(calibration.threads);
+    }
+}
+
+QString formatCalibration(const Calibration &calibration) {
+    QString text = QStringLiteral("Host:       %1\n").arg(hostKey());
+    if (calibration.chunkSize == 0) {
+        return text + "Not calibrated\n";
+    }
+    text += QStringLiteral("Chunk size: %1 KiB\n").arg(calibration.chunkSize / 1024);
+    text += QStringLiteral("Threads:    %1 (%2 MB/s)\n").arg(calibration.threads)
+            .arg(calibration.mbPerSecond, 0, 'f', 1);
+    text += QStringLiteral("Measured:   %1\n").arg(calibration.measured.toString(Qt::ISODate));
+    for (const QString &line: calibration.results) {
+        text += "  " + line + "\n";
+    }
+    return text;
+}
@@ -0,0 +1,34 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <QDateTime>
+#include <QStringList>
+#include <optional>
+
+// Best batch chunk size and thread count for this host, measured on a
+// synthetic corpus and cached in QSettings per host name and CPU count, so
+// a changed machine (or VM size) calibrates again.
+struct Calibration {
+    size_t chunkSize = 0;
+    int threads = 0;
+    double mbPerSecond = 0; // at the chosen values
+    QDateTime measured;
+    QStringList results;    // one line per candidate tried
+};
+
+// The cached calibration for this host, if any.
+std::optional<Calibration> cachedCalibration();
+
+// Measures (a few seconds) and caches. Uses the shared converter.
+Calibration calibrate();
+
+// Forgets this host's calibration (--recalibrate).
+void clearCalibration();
+
+// Sets the batch chunk size, and the scheduler's thread count unless
+// keep_threads (an explicit user setting wins).
+void applyCalibration(const Calibration &calibration, bool keep_threads);
+
+QString formatCalibration(const Calibration &calibration);
+
+#endif // CALIBRATION_H
@@ -0,0 +1,565 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "compressedio.h"
+#include "streamconverter.h"
+
+#ifdef ZHO_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef ZHO_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+    constexpr size_t io_buffer_size = 256 * 1024;
+
+    bool endsWith(const std::string_view text, const std::string_view suffix) {
+        if (text.size() < suffix.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < suffix.size(); ++i) {
+            char c = text[text.size() - suffix.size() + i];
+            if (c >= 'A' && c <= 'Z') {
+                c = static_cast<char>(c - 'A' + 'a');
+            }
+            if (c != suffix[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    class RawSource final : public ByteSource {
+    public:
+        RawSource(FILE *file, std::string prefix) : file(file), prefix(std::move(prefix)) {
+        }
+
+        size_t read(char *data, const size_t size) override {
+            size_t length = 0;
+            if (offset < prefix.size()) {
+                length = std::min(size, prefix.size() - offset);
+                prefix.copy(data, length, offset);
+                offset += length;
+            }
+            if (length < size) {
+                length += std::fread(data + length, 1, size - length, file);
+                if (std::ferror(file)) {
+                    error = "read error";
+                }
+            }
+            return length;
+        }
+
+    private:
+        FILE *file;
+        std::string prefix;
+        size_t offset = 0;
+    };
+
+    class RawSink final : public ByteSink {
+    public:
+        explicit RawSink(FILE *file) : file(file) {
+        }
+
+        bool write(const char *data, const size_t size) override {
+            if (std::fwrite(data, 1, size, file) != size) {
+                error = "write error";
+                return false;
+            }
+            return true;
+        }
+
+        bool finish() override {
+            if (std::fflush(file) != 0) {
+                error = "write error";
+            }
+            return !failed();
+        }
+
+    private:
+        FILE *file;
+    };
+
+    class UnsupportedSource final : public ByteSource {
+    public:
+        explicit UnsupportedSource(const Compression compression) {
+            error = std::string(compressionName(compression)) + " support not available in this build";
+        }
+
+        size_t read(char *, size_t) override { return 0; }
+    };
+
+    class UnsupportedSink final : public ByteSink {
+    public:
+        explicit UnsupportedSink(const Compression compression) {
+            error = std::string(compressionName(compression)) + " support not available in this build";
+        }
+
+        bool write(const char *, size_t) override { return false; }
+
+        bool finish() override { return false; }
+    };
+
+#ifdef ZHO_HAVE_ZLIB
+    class GzipSource final : public ByteSource {
+    public:
+        GzipSource(FILE *file, const std::string &prefix) : file(file), input(io_buffer_size) {
+            // 15 + 32: accept both gzip and zlib headers
+            inflateInit2(&zs, 15 + 32);
+            prefix.copy(reinterpret_cast<char *>(input.data()), prefix.size());
+            zs.next_in = input.data();
+            zs.avail_in = static_cast<uInt>(prefix.size());
+        }
+
+        ~GzipSource() override {
+            inflateEnd(&zs);
+        }
+
+        size_t read(char *data, const size_t size) override {
+            zs.next_out = reinterpret_cast<Bytef *>(data);
+            zs.avail_out = static_cast<uInt>(size);
+            while (zs.avail_out > 0 && !failed()) {
+                if (zs.avail_in == 0 && !eof) {
+                    const size_t length = std::fread(input.data(), 1, input.size(), file);
+                    if (length == 0) {
+                        eof = true;
+                        if (std::ferror(file)) {
+                            error = "read error";
+                        } else if (!memberEnded && zs.total_in > 0) {
+                            error = "truncated gzip stream";
+                        }
+                    }
+                    zs.next_in = input.data();
+                    zs.avail_in = static_cast<uInt>(length);
+                }
+                if (zs.avail_in == 0 && eof) {
+                    break;
+                }
+                memberEnded = false;
+                const int result = inflate(&zs, Z_NO_FLUSH);
+                if (result == Z_STREAM_END) {
+                    // Concatenated members (e.g. from pigz or appended logs)
+                    memberEnded = true;
+                    inflateReset(&zs);
+                } else if (result != Z_OK && result != Z_BUF_ERROR) {
+                    error = "corrupt gzip stream";
+                }
+            }
+            return size - zs.avail_out;
+        }
+
+    private:
+        FILE *file;
+        z_stream zs{};
+        std::vector<Bytef> input;
+        bool eof = false;
+        bool memberEnded = false;
+    };
+
+    class GzipSink final : public ByteSink {
+    public:
+        GzipSink(FILE *file, const int level) : file(file), output(io_buffer_size) {
+            // 15 + 16: write a gzip header rather than a zlib one
+            deflateInit2(&zs, level < 0 ? Z_DEFAULT_COMPRESSION : level, Z_DEFLATED, 15 + 16, 8,
+                         Z_DEFAULT_STRATEGY);
+        }
+
+        ~GzipSink() override {
+            deflateEnd(&zs);
+        }
+
+        bool write(const char *data, const size_t size) override {
+            zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+            zs.avail_in = static_cast<uInt>(size);
+            return deflateAll(Z_NO_FLUSH);
+        }
+
+        bool finish() override {
+            zs.next_in = nullptr;
+            zs.avail_in = 0;
+            if (deflateAll(Z_FINISH) && std::fflush(file) != 0) {
+                error = "write error";
+            }
+            return !failed();
+        }
+
+    private:
+        bool deflateAll(const int flush) {
+            int result;
+            do {
+                zs.next_out = output.data();
+                zs.avail_out = static_cast<uInt>(output.size());
+                result = deflate(&zs, flush);
+                if (result == Z_STREAM_ERROR) {
+                    error = "gzip compression error";
+                    return false;
+                }
+                const size_t length = output.size() - zs.avail_out;
+                if (std::fwrite(output.data(), 1, length, file) != length) {
+                    error = "write error";
+                    return false;
+                }
+            } while (zs.avail_out == 0 || (flush == Z_FINISH && result != Z_STREAM_END));
+            return true;
+        }
+
+        FILE *file;
+        z_stream zs{};
+        std::vector<Bytef> output;
+    };
+#endif
+
+#ifdef ZHO_HAVE_ZSTD
+    class ZstdSource final : public ByteSource {
+    public:
+        ZstdSource(FILE *file, std::string prefix)
+            : file(file), dctx(ZSTD_createDCtx()), input(std::max(io_buffer_size, ZSTD_DStreamInSize())) {
+            prefix.copy(input.data(), prefix.size());
+            in = {input.data(), prefix.size(), 0};
+        }
+
+        ~ZstdSource() override {
+            ZSTD_freeDCtx(dctx);
+        }
+
+        size_t read(char *data, const size_t size) override {
+            ZSTD_outBuffer out{data, size, 0};
+            while (out.pos < out.size && !failed()) {
+                if (in.pos == in.size && !eof) {
+                    const size_t length = std::fread(input.data(), 1, input.size(), file);
+                    if (length == 0) {
+                        eof = true;
+                        if (std::ferror(file)) {
+                            error = "read error";
+                        } else if (pending != 0) {
+                            error = "truncated zstd stream";
+                        }
+                    }
+                    in = {input.data(), length, 0};
+                }
+                if (in.pos == in.size && eof) {
+                    break;
+                }
+                pending = ZSTD_decompressStream(dctx, &out, &in);
+                if (ZSTD_isError(pending)) {
+                    error = std::string("corrupt zstd stream: ") + ZSTD_getErrorName(pending);
+                }
+            }
+            return out.pos;
+        }
+
+    private:
+        FILE *file;
+        ZSTD_DCtx *dctx;
+        std::vector<char> input;
+        ZSTD_inBuffer in{};
+        size_t pending = 0;
+        bool eof = false;
+    };
+
+    class ZstdSink final : public ByteSink {
+    public:
+        ZstdSink(FILE *file, const int level)
+            : file(file), cctx(ZSTD_createCCtx()), output(std::max(io_buffer_size, ZSTD_CStreamOutSize())) {
+            ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level < 0 ? ZSTD_CLEVEL_DEFAULT : level);
+        }
+
+        ~ZstdSink() override {
+            ZSTD_freeCCtx(cctx);
+        }
+
+        bool write(const char *data, const size_t size) override {
+            ZSTD_inBuffer in{data, size, 0};
+            while (in.pos < in.size) {
+                if (!compress(in, ZSTD_e_continue)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool finish() override {
+            ZSTD_inBuffer in{nullptr, 0, 0};
+            for (;;) {
+                const size_t remaining = compress(in, ZSTD_e_end);
+                if (failed() || remaining == 0) {
+                    break;
+                }
+            }
+            if (!failed() && std::fflush(file) != 0) {
+                error = "write error";
+            }
+            return !failed();
+        }
+
+    private:
+        // Returns the number of bytes left to flush (ZSTD_e_end), or 0 on error.
+        size_t compress(ZSTD_inBuffer &in, const ZSTD_EndDirective directive) {
+            ZSTD_outBuffer out{output.data(), output.size(), 0};
+            const size_t remaining = ZSTD_compressStream2(cctx, &out, &in, directive);
+            if (ZSTD_isError(remaining)) {
+                error = std::string("zstd compression error: ") + ZSTD_getErrorName(remaining);
+                return 0;
+            }
+            if (std::fwrite(output.data(), 1, out.pos, file) != out.pos) {
+                error = "write error";
+                return 0;
+            }
+            return directive == ZSTD_e_end ? remaining : 1;
+        }
+
+        FILE *file;
+        ZSTD_CCtx *cctx;
+        std::vector<char> output;
+    };
+#endif
+
+    // Bounded hand-off between pipeline stages. close() ends the stream
+    // normally; abort() also drops queued blocks and wakes a blocked producer.
+    class BlockQueue {
+    public:
+        explicit BlockQueue(const size_t capacity) : capacity(capacity) {
+        }
+
+        bool push(std::string &&block) {
+            std::unique_lock lock(mutex);
+            notFull.wait(lock, [this] { return blocks.size() < capacity || closed; });
+            if (closed) {
+                return false;
+            }
+            blocks.push_back(std::move(block));
+            notEmpty.notify_one();
+            return true;
+        }
+
+        bool pop(std::string &block) {
+            std::unique_lock lock(mutex);
+            notEmpty.wait(lock, [this] { return !blocks.empty() || closed; });
+            if (blocks.empty()) {
+                return false;
+            }
+            block = std::move(blocks.front());
+            blocks.pop_front();
+            notFull.notify_one();
+            return true;
+        }
+
+        void close() {
+            std::lock_guard lock(mutex);
+            closed = true;
+            notEmpty.notify_all();
+            notFull.notify_all();
+        }
+
+        void abort() {
+            std::lock_guard lock(mutex);
+            closed = true;
+            blocks.clear();
+            notEmpty.notify_all();
+            notFull.notify_all();
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable notEmpty;
+        std::condition_variable notFull;
+        std::deque<std::string> blocks;
+        size_t capacity;
+        bool closed = false;
+    };
+}
+
+Compression compressionFromName(const std::string_view path) {
+    if (endsWith(path, ".gz") || endsWith(path, ".gzip")) {
+        return Compression::Gzip;
+    }
+    if (endsWith(path, ".zst") || endsWith(path, ".zstd")) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+Compression compressionFromMagic(const std::string_view head) {
+    if (head.size() >= 2 && head[0] == '\x1f' && head[1] == '\x8b') {
+        return Compression::Gzip;
+    }
+    if (head.size() >= 4 && head.substr(0, 4) == std::string_view("\x28\xb5\x2f\xfd", 4)) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+bool compressionAvailable(const Compression compression) {
+    switch (compression) {
+        case Compression::Gzip:
+#ifdef ZHO_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Compression::Zstd:
+#ifdef ZHO_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return true;
+    }
+}
+
+const char *compressionName(const Compression compression) {
+    switch (compression) {
+        case Compression::Gzip:
+            return "gzip";
+        case Compression::Zstd:
+            return "zstd";
+        default:
+            return "none";
+    }
+}
+
+std::unique_ptr<ByteSource> makeSource(FILE *file) {
+    std::string head(4, '\0');
+    head.resize(std::fread(head.data(), 1, head.size(), file));
+
+    switch (const Compression compression = compressionFromMagic(head)) {
+        case Compression::Gzip:
+#ifdef ZHO_HAVE_ZLIB
+            return std::make_unique<GzipSource>(file, head);
+#else
+            return std::make_unique<UnsupportedSource>(compression);
+#endif
+        case Compression::Zstd:
+#ifdef ZHO_HAVE_ZSTD
+            return std::make_unique<ZstdSource>(file, std::move(head));
+#else
+            return std::make_unique<UnsupportedSource>(compression);
+#endif
+        default:
+            return std::make_unique<RawSource>(file, std::move(head));
+    }
+}
+
+std::unique_ptr<ByteSink> makeSink(FILE *file, const Compression compression, [[maybe_unused]] const int level) {
+    switch (compression) {
+        case Compression::Gzip:
+#ifdef ZHO_HAVE_ZLIB
+            return std::make_unique<GzipSink>(file, level);
+#else
+            return std::make_unique<UnsupportedSink>(compression);
+#endif
+        case Compression::Zstd:
+#ifdef ZHO_HAVE_ZSTD
+            return std::make_unique<ZstdSink>(file, level);
+#else
+            return std::make_unique<UnsupportedSink>(compression);
+#endif
+        default:
+            return std::make_unique<RawSink>(file);
+    }
+}
+
+bool pumpStream(ByteSource &source, ByteSink &sink, StreamConverter &stream, const bool pipelined,
+                std::string &error) {
+    const size_t block_size = stream.blockSize();
+
+    if (!pipelined) {
+        std::vector<char> buffer(block_size);
+        std::string converted;
+        size_t length;
+        while ((length = source.read(buffer.data(), buffer.size())) > 0) {
+            stream.push(std::string_view(buffer.data(), length), converted);
+            if (stream.failed() || !sink.write(converted.data(), converted.size())) {
+                break;
+            }
+            converted.clear();
+        }
+        if (!source.failed() && !sink.failed() && !stream.failed()) {
+            stream.finish(converted);
+            if (!stream.failed() && sink.write(converted.data(), converted.size())) {
+                sink.finish();
+            }
+        }
+    } else {
+        // Two blocks in flight per queue keep every stage busy while
+        // bounding memory to a handful of blocks.
+        BlockQueue raw(2);
+        BlockQueue converted(2);
+
+        std::thread reader([&] {
+            for (;;) {
+                std::string block(block_size, '\0');
+                const size_t length = source.read(block.data(), block.size());
+                if (length == 0) {
+                    break;
+                }
+                block.resize(length);
+                if (!raw.push(std::move(block))) {
+                    break;
+                }
+            }
+            raw.close();
+        });
+
+        std::thread writer([&] {
+            std::string block;
+            while (converted.pop(block)) {
+                if (!sink.write(block.data(), block.size())) {
+                    converted.abort();
+                    raw.abort();
+                    break;
+                }
+            }
+        });
+
+        std::string block;
+        std::string out;
+        bool open = true;
+        while (open && raw.pop(block)) {
+            out.clear();
+            stream.push(block, out);
+            if (stream.failed()) {
+                raw.abort();
+                break;
+            }
+            if (!out.empty()) {
+                open = converted.push(std::move(out));
+            }
+        }
+        if (open && !source.failed() && !stream.failed()) {
+            out.clear();
+            stream.finish(out);
+            if (!stream.failed()) {
+                converted.push(std::move(out));
+            }
+        }
+        converted.close();
+        reader.join();
+        writer.join();
+
+        if (!source.failed() && !sink.failed() && !stream.failed()) {
+            sink.finish();
+        }
+    }
+
+    if (stream.failed()) {
+        error = "conversion failed";
+        return false;
+    }
+
+    if (source.failed()) {
+        error = source.errorString();
+        return false;
+    }
+    if (sink.failed()) {
+        error = sink.errorString();
+        return false;
+    }
+    return true;
+}
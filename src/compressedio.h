@@ -0,0 +1,81 @@
+#ifndef COMPRESSEDIO_H
+#define COMPRESSEDIO_H
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+
+class StreamConverter;
+
+// Transparent gzip / zstd input and output for the batch and command line
+// paths. gzip needs zlib (ZHO_HAVE_ZLIB) and zstd needs libzstd
+// (ZHO_HAVE_ZSTD) at build time; without them such files are reported as
+// unsupported instead of being converted as binary garbage.
+enum class Compression {
+    None,
+    Gzip,
+    Zstd
+};
+
+// By file name suffix (.gz / .zst).
+Compression compressionFromName(std::string_view path);
+
+// By stream header (gzip and zstd magic numbers).
+Compression compressionFromMagic(std::string_view head);
+
+bool compressionAvailable(Compression compression);
+
+const char *compressionName(Compression compression);
+
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+
+    // Fills up to size bytes of decoded data. Returns 0 at end of stream or
+    // on error (see failed()).
+    virtual size_t read(char *data, size_t size) = 0;
+
+    bool failed() const { return !error.empty(); }
+
+    const std::string &errorString() const { return error; }
+
+protected:
+    std::string error;
+};
+
+class ByteSink {
+public:
+    virtual ~ByteSink() = default;
+
+    virtual bool write(const char *data, size_t size) = 0;
+
+    // Flushes the encoder trailer and the underlying file.
+    virtual bool finish() = 0;
+
+    bool failed() const { return !error.empty(); }
+
+    const std::string &errorString() const { return error; }
+
+protected:
+    std::string error;
+};
+
+// Wraps an open file, detecting the compression from its first bytes. The
+// file is not owned and must outlive the source.
+std::unique_ptr<ByteSource> makeSource(FILE *file);
+
+// Wraps an open file, compressing with the given method. level < 0 selects
+// the library default. The file is not owned and must outlive the sink.
+std::unique_ptr<ByteSink> makeSink(FILE *file, Compression compression, int level = -1);
+
+// Moves the whole stream from source through the converter into sink. When
+// pipelined, reading / decompression and writing / compression each run on
+// their own thread, connected to the converting (calling) thread by small
+// bounded queues, so the three stages overlap on different cores. Returns
+// false with error set when reading, converting (see
+// StreamConverter::failed()) or writing fails.
+bool pumpStream(ByteSource &source, ByteSink &sink, StreamConverter &stream, bool pipelined,
+                std::string &error);
+
+#endif // COMPRESSEDIO_H
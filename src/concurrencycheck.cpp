@@ -0,0 +1,126 @@
+#include <QElapsedTimer>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "concurrencycheck.h"
+#include "convertermanager.h"
+
+namespace {
+    const char *const texts[] = {
+        u8"简体中文转换为繁体中文，这是一个测试句子。头发和发展，干燥和干部。\n",
+        u8"計算機軟體與頭髮的轉換，臺灣和香港的用字。「引號」和『雙引號』。\n",
+        u8"日本語の漢字と仮名、新字体の国語。\n",
+        "Plain ASCII text with no CJK at all.\n"
+    };
+    constexpr int text_count = static_cast<int>(std::size(texts));
+    // Each text repeated to about this size, long enough for the library
+    // to split one call across its own threads
+    constexpr size_t text_size = 64 * 1024;
+
+    // Case index: text, config and punctuation flag
+    constexpr int case_count = text_count * zho_config_count * 2;
+
+    struct Case {
+        const std::string *text;
+        ZhoConfig config;
+        bool punctuation;
+    };
+
+    Case caseAt(const std::vector<std::string> &inputs, const int index) {
+        return {&inputs[index % text_count], static_cast<ZhoConfig>(index / text_count % zho_config_count),
+                index / (text_count * zho_config_count) == 1};
+    }
+}
+
+int runConcurrencyCheck(const ConcurrencyCheckOptions &options) {
+    if (options.threads <= 0 || options.seconds <= 0) {
+        std::fprintf(stderr, "Invalid check options\n");
+        return 1;
+    }
+    std::vector<std::string> inputs;
+    for (const char *text: texts) {
+        std::string input;
+        while (input.size() < text_size) {
+            input += text;
+        }
+        inputs.push_back(std::move(input));
+    }
+
+    // Expected results, from one thread
+    std::vector<std::string> expected(case_count);
+    std::vector<int> expected_codes(text_count);
+    {
+        const ConverterLease converter = sharedConverter();
+        if (!converter) {
+            std::fprintf(stderr, "zhoconv: %s\n", qPrintable(ConverterManager::instance().lastError()));
+            return 1;
+        }
+        for (int index = 0; index < case_count; ++index) {
+            const Case test = caseAt(inputs, index);
+            expected[index] = zhoConvert(converter.get(), test.text->c_str(), test.config, test.punctuation);
+        }
+        for (int index = 0; index < text_count; ++index) {
+            expected_codes[index] = converter->check(inputs[index].c_str());
+        }
+        std::printf("Backend %s, %d threads, %d s, %d cases, evicting every %d ms\n",
+                    qPrintable(converter->name()), options.threads, options.seconds, case_count, options.evictMsec);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<quint64> operations{0};
+    std::atomic<int> mismatches{0};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < options.threads; ++t) {
+        threads.emplace_back([&, t] {
+            // Threads walk the cases from different starting points, so
+            // different configs run at the same time
+            int index = t * 7919 % case_count;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const ConverterLease converter = sharedConverter();
+                if (!converter) {
+                    ++failures;
+                    continue;
+                }
+                const Case test = caseAt(inputs, index);
+                if (zhoConvert(converter.get(), test.text->c_str(), test.config, test.punctuation) !=
+                    expected[index]) {
+                    if (mismatches++ < 10) {
+                        std::printf("Mismatch: %s, punctuation %d, text %d\n", configName(test.config),
+                                    test.punctuation, index % text_count);
+                    }
+                }
+                if (converter->check(test.text->c_str()) != expected_codes[index % text_count]) {
+                    ++mismatches;
+                }
+                ++operations;
+                index = (index + 1) % case_count;
+            }
+        });
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int evictions = 0;
+    while (timer.elapsed() < options.seconds * 1000LL) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(options.evictMsec > 0 ? options.evictMsec : 100));
+        if (options.evictMsec > 0) {
+            ConverterManager::instance().evict("stress");
+            ++evictions;
+        }
+    }
+    stop = true;
+    for (std::thread &thread: threads) {
+        thread.join();
+    }
+
+    const double seconds = static_cast<double>(timer.elapsed()) / 1000;
+    std::printf("%llu operations (%.0f/s), %d evictions, %d load failures, %d mismatches\n",
+                static_cast<unsigned long long>(operations.load()), static_cast<double>(operations.load()) / seconds,
+                evictions, failures.load(), mismatches.load());
+    return mismatches > 0 || failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+#ifndef CONCURRENCYCHECK_H
+#define CONCURRENCYCHECK_H
+
+struct ConcurrencyCheckOptions {
+    int threads = 32;
+    int seconds = 30;
+    // Evict the shared instance this often while the threads run, so leases
+    // outlive evictions and loads race with conversions (0: never)
+    int evictMsec = 500;
+};
+
+// Checks the converter backend contract (see IConverterBackend): many
+// threads take leases on the shared instance and convert and check a set
+// of texts with every config, with and without punctuation, comparing each
+// result with the single-threaded one, while another thread keeps evicting
+// the instance. Prints operations, loads and mismatches. Returns 1 on any
+// mismatch. Run a ZHO_WITH_TSAN build to have ThreadSanitizer watch too.
+int runConcurrencyCheck(const ConcurrencyCheckOptions &options);
+
+#endif // CONCURRENCYCHECK_H
@@ -0,0 +1,165 @@
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <mutex>
+#include "converterbackend.h"
+#include "opencc_fmmseg_capi.h"
+
+#if defined(Q_OS_WIN)
+#define NOMINMAX
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <dlfcn.h>
+#endif
+
+#if defined(__SANITIZE_THREAD__)
+#define ZHO_TSAN
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define ZHO_TSAN
+#endif
+#endif
+
+#ifdef ZHO_TSAN
+extern "C" void __tsan_acquire(void *address);
+extern "C" void __tsan_release(void *address);
+#endif
+
+namespace {
+    // Happens-before edges ThreadSanitizer cannot see through the
+    // uninstrumented library: building the instance precedes every call
+    // on it, and every call precedes freeing it.
+    void tsanRelease([[maybe_unused]] void *address) {
+#ifdef ZHO_TSAN
+        __tsan_release(address);
+#endif
+    }
+
+    void tsanAcquire([[maybe_unused]] void *address) {
+#ifdef ZHO_TSAN
+        __tsan_acquire(address);
+#endif
+    }
+
+    // The C API has no version call: name the library file and a hash of
+    // its contents, which changes with every build of it
+    QString libraryVersion() {
+        QString path;
+#if defined(Q_OS_WIN)
+        HMODULE module = nullptr;
+        wchar_t name[MAX_PATH];
+        if (GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                               reinterpret_cast<LPCWSTR>(&opencc_new), &module) &&
+            GetModuleFileNameW(module, name, MAX_PATH) > 0) {
+            path = QString::fromWCharArray(name);
+        }
+#elif defined(Q_OS_UNIX)
+        Dl_info info{};
+        if (dladdr(reinterpret_cast<void *>(&opencc_new), &info) != 0 && info.dli_fname != nullptr) {
+            path = QFile::decodeName(info.dli_fname);
+        }
+#endif
+        QFile file(path);
+        if (path.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+            return {};
+        }
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(&file);
+        return QFileInfo(path).fileName() + '@' + QString::fromLatin1(hash.result().toHex().left(12));
+    }
+
+    class OpenccBackend : public IConverterBackend {
+    public:
+        explicit OpenccBackend(void *instance) : handle(instance) {
+            tsanRelease(handle);
+        }
+
+        ~OpenccBackend() override {
+            tsanAcquire(handle);
+            opencc_free(handle);
+        }
+
+        QString name() const override { return default_backend; }
+
+        int capabilities() const override { return Punctuation | Check; }
+
+        QString version() const override {
+            static const QString version = libraryVersion();
+            return version;
+        }
+
+        bool convert(const char *text, const ZhoConfig config, const bool punctuation,
+                     std::string &out) const override {
+            tsanAcquire(handle);
+            char *output = opencc_convert(handle, text, configName(config), punctuation);
+            tsanRelease(handle);
+            if (output == nullptr) {
+                return false;
+            }
+            out.append(output);
+            opencc_string_free(output);
+            return true;
+        }
+
+        int check(const char *text) const override {
+            tsanAcquire(handle);
+            const int code = opencc_zho_check(handle, text);
+            tsanRelease(handle);
+            return code;
+        }
+
+    private:
+        void *handle;
+    };
+
+    std::mutex registry_mutex;
+
+    QMap<QString, BackendFactory> &registry() {
+        static QMap<QString, BackendFactory> factories{
+            {
+                default_backend, [](QString &error) -> std::unique_ptr<IConverterBackend> {
+                    void *handle = opencc_new();
+                    if (handle == nullptr) {
+                        error = QString::fromUtf8(opencc_last_error());
+                        return nullptr;
+                    }
+                    return std::make_unique<OpenccBackend>(handle);
+                }
+            }
+        };
+        return factories;
+    }
+}
+
+std::vector<std::string> IConverterBackend::convertBatch(const std::vector<std::string> &texts,
+                                                         const ZhoConfig config, const bool punctuation) const {
+    std::vector<std::string> outputs(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        convert(texts[i].c_str(), config, punctuation, outputs[i]);
+    }
+    return outputs;
+}
+
+void registerBackend(const QString &name, BackendFactory factory) {
+    std::lock_guard lock(registry_mutex);
+    registry().insert(name, std::move(factory));
+}
+
+QStringList backendNames() {
+    std::lock_guard lock(registry_mutex);
+    return registry().keys();
+}
+
+std::unique_ptr<IConverterBackend> createBackend(const QString &name, QString &error) {
+    BackendFactory factory;
+    {
+        std::lock_guard lock(registry_mutex);
+        factory = registry().value(name);
+    }
+    if (!factory) {
+        error = QStringLiteral("unknown converter backend %1").arg(name);
+        return nullptr;
+    }
+    return factory(error);
+}
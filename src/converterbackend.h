@@ -0,0 +1,95 @@
+#ifndef CONVERTERBACKEND_H
+#define CONVERTERBACKEND_H
+
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "zhoconfig.h"
+
+// A conversion engine. Everything that converts or detects the script goes
+// through this interface on the instance ConverterManager hands out, so
+// adopting another engine takes an implementation and a registerBackend()
+// call, not changes to the UI or the batch code.
+//
+// Thread-safety contract, which ConverterManager relies on to share one
+// instance instead of loading one per thread: every method is const and
+// may run on one instance from any number of threads at once, and the
+// destructor runs once, after the last ConverterLease is gone. Check a
+// backend against it with zhoconv --stress (in a ZHO_WITH_TSAN build to
+// have ThreadSanitizer watch).
+//
+// The batch and stream converters convert large texts in pieces cut at
+// find_split_boundary(), so convert() must give the same bytes for the
+// pieces as for the whole text; zhoconv --verify checks that.
+//
+// The built-in opencc-fmmseg backend meets it as follows:
+//   - opencc_convert() and opencc_zho_check() only read the instance;
+//     the stress check finds no difference from single-threaded output
+//   - opencc_set_parallel() writes it and is never called; the library
+//     default (parallel within one call) is kept
+//   - opencc_last_error() is process-wide; it is read only by the thread
+//     whose load just failed, and ConverterManager runs one load at a time
+// The library is not instrumented, so the wrapper tells ThreadSanitizer
+// that publishing the instance happens before its use on other threads.
+class IConverterBackend {
+public:
+    enum Capability {
+        Punctuation = 0x1, // honours the punctuation flag
+        Check = 0x2,       // check() detects the script
+        Batch = 0x8        // convertBatch() beats a loop of convert()
+    };
+
+    virtual ~IConverterBackend() = default;
+
+    virtual QString name() const = 0;
+
+    virtual int capabilities() const = 0;
+
+    // Identifies the engine build, so stored results can tell engine
+    // updates apart. Empty if unknown.
+    virtual QString version() const { return {}; }
+
+    // Appends the conversion of the NUL-terminated text to out. Returns
+    // false, leaving out unchanged, on failure.
+    virtual bool convert(const char *text, ZhoConfig config, bool punctuation, std::string &out) const = 0;
+
+    // The script of text, as opencc_zho_check() codes it (1 traditional,
+    // 2 simplified, 0 other). 0 without the Check capability.
+    virtual int check(const char *text) const = 0;
+
+    // Converts every text; the default calls convert() for each.
+    virtual std::vector<std::string> convertBatch(const std::vector<std::string> &texts, ZhoConfig config,
+                                                  bool punctuation) const;
+};
+
+// Builds a backend instance, or returns nullptr and sets error.
+using BackendFactory = std::function<std::unique_ptr<IConverterBackend>(QString &error)>;
+
+// The opencc_fmmseg C API, always registered
+inline const QString default_backend = QStringLiteral("opencc-fmmseg");
+
+// Adds or replaces the backend registered under name.
+void registerBackend(const QString &name, BackendFactory factory);
+
+QStringList backendNames();
+
+// A new instance of the named backend, or nullptr with error set when the
+// name is unknown or loading fails.
+std::unique_ptr<IConverterBackend> createBackend(const QString &name, QString &error);
+
+// converter->convert() into a new string; empty on failure, which ok (if
+// given) reports. A null converter (a lease whose load failed) fails.
+inline std::string zhoConvert(const IConverterBackend *converter, const char *input, const ZhoConfig config,
+                              const bool punctuation, bool *ok = nullptr) {
+    std::string output;
+    const bool converted = converter != nullptr && converter->convert(input, config, punctuation, output);
+    if (ok != nullptr) {
+        *ok = converted;
+    }
+    return output;
+}
+
+#endif // CONVERTERBACKEND_H
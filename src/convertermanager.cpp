@@ -0,0 +1,292 @@
+#include <QElapsedTimer>
+#include <QTime>
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+#include "convertermanager.h"
+#include "metrics.h"
+#include "zhoconfig.h"
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#endif
+
+namespace {
+    constexpr int max_events = 200;
+
+    // Short enough to be free, long enough to touch both script directions
+    const char *const warm_sample = u8"简体中文转换，繁體中文轉換，日本語の漢字。";
+}
+
+ConverterManager &ConverterManager::instance() {
+    static ConverterManager manager;
+    return manager;
+}
+
+ConverterManager::ConverterManager() {
+    lastUse.start();
+}
+
+ConverterLease ConverterManager::acquire() {
+    std::unique_lock locker(mutex);
+    lastUse.start();
+    while (true) {
+        if (current) {
+            Metrics::add(Metrics::CacheHits);
+            return current;
+        }
+        // Evicted while a conversion still held it: take it back
+        if (ConverterLease alive = lastInstance.lock()) {
+            Metrics::add(Metrics::CacheHits);
+            current = std::move(alive);
+            logEvent("reattached (still in use at eviction)");
+            return current;
+        }
+        if (!loading) {
+            break;
+        }
+        // Another thread is loading; wait for its instance rather than load
+        // a second one
+        loadDone.wait(locker);
+    }
+
+    // Loaded without the lock, so isLoaded(), noteUsed() and the rest do not
+    // wait for the dictionaries
+    Metrics::add(Metrics::CacheMisses);
+    loading = true;
+    const QString name = backend;
+    locker.unlock();
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 before = residentBytes();
+    QString error;
+    ConverterLease instance = createBackend(name, error);
+    const qint64 bytes = std::max<qint64>(0, residentBytes() - before);
+    locker.lock();
+    loading = false;
+    loadDone.notify_all();
+
+    if (instance == nullptr) {
+        loadError = error;
+        logEvent("load failed: " + error);
+        return {};
+    }
+    // setBackend() ran meanwhile: this caller gets the instance it asked
+    // for, but the next acquire() loads the new backend
+    if (name != backend) {
+        return instance;
+    }
+    current = std::move(instance);
+    lastInstance = current;
+    instanceBytes = bytes;
+    logEvent(QStringLiteral("loaded %1 in %2 ms, %3 MiB")
+        .arg(name)
+        .arg(timer.elapsed())
+        .arg(static_cast<double>(instanceBytes) / (1024 * 1024), 0, 'f', 1));
+    return current;
+}
+
+void ConverterManager::setBackend(const QString &name) {
+    std::lock_guard locker(mutex);
+    if (name == backend) {
+        return;
+    }
+    backend = name;
+    current.reset();
+    lastInstance.reset();
+    warmConfigs.clear();
+    logEvent("backend set to " + name);
+}
+
+QString ConverterManager::backendName() const {
+    std::lock_guard locker(mutex);
+    return backend;
+}
+
+QString ConverterManager::lastError() const {
+    std::lock_guard locker(mutex);
+    return loadError;
+}
+
+ConverterLease sharedConverter() {
+    return ConverterManager::instance().acquire();
+}
+
+bool ConverterManager::isLoaded() const {
+    std::lock_guard locker(mutex);
+    return current != nullptr;
+}
+
+qint64 ConverterManager::idleMsec() const {
+    std::lock_guard locker(mutex);
+    return lastUse.elapsed();
+}
+
+void ConverterManager::noteUsed(const QString &config) {
+    std::lock_guard locker(mutex);
+    ++usageCounts[config];
+}
+
+QStringList ConverterManager::mostUsed(const int count) const {
+    std::lock_guard locker(mutex);
+    QList<std::pair<int, QString>> ranked;
+    for (auto it = usageCounts.cbegin(); it != usageCounts.cend(); ++it) {
+        ranked.append({it.value(), it.key()});
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) {
+        return a.first > b.first;
+    });
+    QStringList configs;
+    for (int i = 0; i < std::min(count, static_cast<int>(ranked.size())); ++i) {
+        configs.append(ranked.at(i).second);
+    }
+    return configs;
+}
+
+QVariantMap ConverterManager::usage() const {
+    std::lock_guard locker(mutex);
+    QVariantMap counts;
+    for (auto it = usageCounts.cbegin(); it != usageCounts.cend(); ++it) {
+        counts.insert(it.key(), it.value());
+    }
+    return counts;
+}
+
+void ConverterManager::restoreUsage(const QVariantMap &counts) {
+    std::lock_guard locker(mutex);
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it) {
+        usageCounts[it.key()] = it.value().toInt();
+    }
+}
+
+void ConverterManager::preload(const QStringList &configs) {
+    if (preloading.exchange(true)) {
+        return;
+    }
+    if (const ConverterLease converter = acquire()) {
+        for (const QString &config: configs) {
+            {
+                std::lock_guard locker(mutex);
+                if (warmConfigs.contains(config)) {
+                    continue;
+                }
+            }
+            QElapsedTimer timer;
+            timer.start();
+            ZhoConfig zho_config;
+            if (!parseConfig(config.toStdString(), zho_config)) {
+                continue;
+            }
+            std::string output;
+            converter->convert(warm_sample, zho_config, false, output);
+
+            std::lock_guard locker(mutex);
+            warmConfigs.insert(config);
+            logEvent(QStringLiteral("warmed %1 in %2 ms").arg(config).arg(timer.elapsed()));
+        }
+    }
+    preloading = false;
+}
+
+void ConverterManager::evict(const QString &reason) {
+    std::lock_guard locker(mutex);
+    if (!current) {
+        return;
+    }
+    current.reset();
+    warmConfigs.clear();
+    logEvent("evicted: " + reason);
+}
+
+bool ConverterManager::evictIfNeeded(const qint64 budget_bytes, const qint64 idle_msec) {
+    if (!isLoaded() || idleMsec() < idle_msec) {
+        return false;
+    }
+    if (const double pressure = memoryPressure(); pressure >= pressure_threshold) {
+        evict(QStringLiteral("memory pressure %1%").arg(pressure, 0, 'f', 1));
+        return true;
+    }
+    if (const qint64 resident = residentBytes(); budget_bytes > 0 && resident > budget_bytes) {
+        evict(QStringLiteral("%1 MiB resident, budget %2 MiB")
+            .arg(resident / (1024 * 1024))
+            .arg(budget_bytes / (1024 * 1024)));
+        return true;
+    }
+    return false;
+}
+
+bool ConverterManager::canPreload(const qint64 budget_bytes) const {
+    if (memoryPressure() >= pressure_threshold) {
+        return false;
+    }
+    if (budget_bytes <= 0) {
+        return true;
+    }
+    std::lock_guard locker(mutex);
+    return residentBytes() + instanceBytes <= budget_bytes;
+}
+
+qint64 ConverterManager::residentBytes() {
+#if defined(Q_OS_LINUX)
+    FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    long long size = 0;
+    long long resident = 0;
+    const int fields = std::fscanf(statm, "%lld %lld", &size, &resident);
+    std::fclose(statm);
+    return fields == 2 ? resident * sysconf(_SC_PAGESIZE) : 0;
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters{};
+    return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))
+               ? static_cast<qint64>(counters.WorkingSetSize)
+               : 0;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    return task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) ==
+           KERN_SUCCESS
+               ? static_cast<qint64>(info.resident_size)
+               : 0;
+#else
+    return 0;
+#endif
+}
+
+double ConverterManager::memoryPressure() {
+#ifdef Q_OS_LINUX
+    FILE *pressure = std::fopen("/proc/pressure/memory", "r");
+    if (pressure == nullptr) {
+        return -1;
+    }
+    double avg10 = -1;
+    if (std::fscanf(pressure, "some avg10=%lf", &avg10) != 1) {
+        avg10 = -1;
+    }
+    std::fclose(pressure);
+    return avg10;
+#else
+    return -1;
+#endif
+}
+
+QStringList ConverterManager::events() const {
+    std::lock_guard locker(mutex);
+    return eventLog;
+}
+
+// Called with the mutex held.
+void ConverterManager::logEvent(const QString &event) {
+    qInfo("converter: %s", qPrintable(event));
+    eventLog.append(QTime::currentTime().toString("hh:mm:ss ") + event);
+    if (eventLog.size() > max_events) {
+        eventLog.removeFirst();
+    }
+}
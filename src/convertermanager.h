@@ -0,0 +1,113 @@
+#ifndef CONVERTERMANAGER_H
+#define CONVERTERMANAGER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QVariantMap>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include "converterbackend.h"
+
+// A reference to the process-wide converter instance. Hold it for as long
+// as the instance is in use; the instance is freed when it has been evicted
+// and the last lease is gone.
+using ConverterLease = std::shared_ptr<const IConverterBackend>;
+
+// Owns the process-wide converter instance of the selected backend (see
+// IConverterBackend): built on first acquire(), shared by every caller and
+// thread (as the backend contract allows), and released again by evict()
+// when memory is short.
+//
+// opencc_fmmseg loads the dictionaries of all configs together inside
+// opencc_new(), so the unit of loading and eviction is the whole instance:
+// about 25 ms and 8-10 MiB resident on Linux x86-64. That is what sharing
+// saves per thread, and what each worker process still pays once (workers
+// report it when ready).
+// What is tracked per config is usage, so preload() can warm the configs
+// the user converts with most before they are needed.
+class ConverterManager {
+public:
+    static ConverterManager &instance();
+
+    // The instance, loading it first if needed. While one thread loads,
+    // other acquire() calls wait for it; nothing else does.
+    ConverterLease acquire();
+
+    // Switches to the named backend (see backendNames()); the next
+    // acquire() loads it. Running conversions keep the old instance.
+    void setBackend(const QString &name);
+
+    QString backendName() const;
+
+    // Why the last load failed.
+    QString lastError() const;
+
+    bool isLoaded() const;
+
+    // Milliseconds since the last acquire().
+    qint64 idleMsec() const;
+
+    // Counts a conversion with config, for mostUsed().
+    void noteUsed(const QString &config);
+
+    QStringList mostUsed(int count) const;
+
+    QVariantMap usage() const;
+
+    void restoreUsage(const QVariantMap &counts);
+
+    // Loads the instance if needed and runs a short conversion with every
+    // config not yet warm. Blocking; run it on a pool thread.
+    void preload(const QStringList &configs);
+
+    // Drops the manager's reference; running conversions keep theirs.
+    void evict(const QString &reason);
+
+    // Evicts when the instance has been idle for idle_msec and either the
+    // process is over budget_bytes (0: no budget) or the system reports
+    // memory pressure. Returns true if it evicted.
+    bool evictIfNeeded(qint64 budget_bytes, qint64 idle_msec);
+
+    // True when reloading now would not immediately be evicted again.
+    bool canPreload(qint64 budget_bytes) const;
+
+    // Resident set size of this process in bytes, or 0 where unknown.
+    static qint64 residentBytes();
+
+    // Linux PSI "some avg10" for memory in percent, or -1 where unknown.
+    static double memoryPressure();
+
+    static constexpr double pressure_threshold = 10.0;
+
+    // Load / warm / evict events, oldest first, for the diagnostics view.
+    QStringList events() const;
+
+private:
+    ConverterManager();
+
+    void logEvent(const QString &event);
+
+    mutable std::mutex mutex;
+    // Set while a thread loads the instance outside the mutex
+    bool loading = false;
+    std::condition_variable loadDone;
+    QString backend = default_backend;
+    QString loadError;
+    ConverterLease current;
+    std::weak_ptr<const IConverterBackend> lastInstance;
+    QSet<QString> warmConfigs;
+    QHash<QString, int> usageCounts;
+    QStringList eventLog;
+    QElapsedTimer lastUse;
+    qint64 instanceBytes = 0;
+    std::atomic<bool> preloading{false};
+};
+
+// Shorthand for ConverterManager::instance().acquire().
+ConverterLease sharedConverter();
+
+#endif // CONVERTERMANAGER_H
@@ -0,0 +1,216 @@
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+#include "cpuplacement.h"
+
+#if defined(Q_OS_LINUX)
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace {
+    // CPU numbers a list may name: what an affinity mask holds
+#if defined(Q_OS_LINUX)
+    constexpr int cpu_limit = CPU_SETSIZE;
+#elif defined(Q_OS_WIN)
+    constexpr int cpu_limit = static_cast<int>(sizeof(DWORD_PTR) * 8);
+#else
+    constexpr int cpu_limit = 1024;
+#endif
+
+    // Cores at or above this share of the fastest core count as performance
+    // cores; absorbs the small turbo differences between cores of one type.
+    constexpr double performance_share = 0.8;
+
+    QString readSysfs(const QString &path) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return {};
+        }
+        return QString::fromLatin1(file.readAll()).trimmed();
+    }
+
+    QList<int> onlineCpus() {
+        QList<int> cpus;
+#ifdef Q_OS_LINUX
+        if (parseCpuList(readSysfs("/sys/devices/system/cpu/online"), cpus) && !cpus.isEmpty()) {
+            return cpus;
+        }
+        cpus.clear();
+#endif
+        for (int cpu = 0; cpu < QThread::idealThreadCount(); ++cpu) {
+            cpus.append(cpu);
+        }
+        return cpus;
+    }
+
+#ifdef Q_OS_LINUX
+    // Splits cpus by a per-CPU sysfs value (capacity or maximum frequency).
+    bool splitByValue(const QList<int> &cpus, const char *file, CpuTopology &topology) {
+        QHash<int, qint64> values;
+        qint64 top = 0;
+        for (const int cpu: cpus) {
+            bool ok = false;
+            const qint64 value = readSysfs(QStringLiteral("/sys/devices/system/cpu/cpu%1/%2").arg(cpu).arg(file))
+                    .toLongLong(&ok);
+            if (!ok) {
+                return false;
+            }
+            values.insert(cpu, value);
+            top = std::max(top, value);
+        }
+        for (const int cpu: cpus) {
+            (values.value(cpu) >= top * performance_share ? topology.performance : topology.efficiency).append(cpu);
+        }
+        return true;
+    }
+#endif
+}
+
+QList<int> CpuTopology::all() const {
+    QList<int> cpus = performance + efficiency;
+    std::sort(cpus.begin(), cpus.end());
+    return cpus;
+}
+
+const CpuTopology &cpuTopology() {
+    static const CpuTopology topology = [] {
+        CpuTopology detected;
+        const QList<int> online = onlineCpus();
+#ifdef Q_OS_LINUX
+        QList<int> core;
+        QList<int> atom;
+        if (parseCpuList(readSysfs("/sys/devices/cpu_core/cpus"), core) && !core.isEmpty() &&
+            parseCpuList(readSysfs("/sys/devices/cpu_atom/cpus"), atom) && !atom.isEmpty()) {
+            detected.performance = core;
+            detected.efficiency = atom;
+            return detected;
+        }
+        if (splitByValue(online, "cpu_capacity", detected)) {
+            return detected;
+        }
+        detected = CpuTopology();
+        if (splitByValue(online, "cpufreq/cpuinfo_max_freq", detected)) {
+            return detected;
+        }
+        detected = CpuTopology();
+#endif
+        detected.performance = online;
+        return detected;
+    }();
+    return topology;
+}
+
+QList<int> placementCpus(const CpuPlacement &placement, const bool heavy) {
+    const CpuTopology &topology = cpuTopology();
+    const QList<int> cpus = placement.cpus.isEmpty() ? topology.all() : placement.cpus;
+    if (!placement.preferPerformanceCores || !topology.isHybrid()) {
+        return cpus;
+    }
+    QList<int> preferred;
+    for (const int cpu: cpus) {
+        if ((heavy ? topology.performance : topology.efficiency).contains(cpu)) {
+            preferred.append(cpu);
+        }
+    }
+    return preferred.isEmpty() ? cpus : preferred;
+}
+
+bool parseCpuList(const QString &text, QList<int> &cpus) {
+    cpus.clear();
+    for (const QString &part: text.split(',', Qt::SkipEmptyParts)) {
+        const QStringList range = part.trimmed().split('-');
+        bool first_ok = false;
+        bool last_ok = false;
+        const int first = range.first().toInt(&first_ok);
+        const int last = range.size() == 2 ? range.last().toInt(&last_ok) : first;
+        if (!first_ok || (range.size() == 2 && !last_ok) || range.size() > 2 || first < 0 || last < first ||
+            last >= cpu_limit) {
+            cpus.clear();
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.append(cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return true;
+}
+
+QString formatCpuList(const QList<int> &cpus) {
+    QStringList parts;
+    for (qsizetype i = 0; i < cpus.size();) {
+        qsizetype j = i;
+        while (j + 1 < cpus.size() && cpus.at(j + 1) == cpus.at(j) + 1) {
+            ++j;
+        }
+        parts.append(j == i ? QString::number(cpus.at(i)) : QStringLiteral("%1-%2").arg(cpus.at(i)).arg(cpus.at(j)));
+        i = j + 1;
+    }
+    return parts.join(',');
+}
+
+bool setThreadAffinity(const QList<int> &cpus) {
+    const QList<int> targets = cpus.isEmpty() ? cpuTopology().all() : cpus;
+#if defined(Q_OS_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const int cpu: targets) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(Q_OS_WIN)
+    DWORD_PTR mask = 0;
+    for (const int cpu: targets) {
+        if (cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+    return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+    Q_UNUSED(targets)
+    return false;
+#endif
+}
+
+bool setThreadNice(const int nice) {
+#ifdef Q_OS_LINUX
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), nice) == 0;
+#else
+    QThread::currentThread()->setPriority(nice >= 10
+                                              ? QThread::LowestPriority
+                                              : nice > 0
+                                                    ? QThread::LowPriority
+                                                    : QThread::NormalPriority);
+    return true;
+#endif
+}
+
+int lowestThreadNice(const int current) {
+#ifdef Q_OS_LINUX
+    if (geteuid() == 0) {
+        return -20;
+    }
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NICE, &limit) != 0) {
+        return current;
+    }
+    if (limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur >= 40) {
+        return -20;
+    }
+    return std::min(current, 20 - static_cast<int>(limit.rlim_cur));
+#else
+    Q_UNUSED(current)
+    return 0;
+#endif
+}
@@ -0,0 +1,53 @@
+#ifndef CPUPLACEMENT_H
+#define CPUPLACEMENT_H
+
+#include <QList>
+#include <QString>
+
+// Where and how eagerly conversion threads run: the CPUs they may use, the
+// nice level of pool threads, and whether heavy work (batch chunks,
+// interactive conversions) is kept on performance cores and light work
+// (speculative, background) on efficiency cores of a hybrid CPU.
+struct CpuPlacement {
+    QList<int> cpus; // empty: all online CPUs
+    int nice = 0;
+    bool preferPerformanceCores = false;
+};
+
+// Core types as reported by Linux sysfs: Intel hybrid parts list them under
+// /sys/devices/cpu_core and cpu_atom, ARM big.LITTLE through cpu_capacity,
+// otherwise cores are grouped by cpuinfo_max_freq. Elsewhere, or on a
+// uniform CPU, every online CPU is a performance core.
+struct CpuTopology {
+    QList<int> performance;
+    QList<int> efficiency;
+
+    bool isHybrid() const { return !performance.isEmpty() && !efficiency.isEmpty(); }
+
+    QList<int> all() const;
+};
+
+const CpuTopology &cpuTopology();
+
+// CPUs a thread doing heavy (or light) work should use under placement.
+QList<int> placementCpus(const CpuPlacement &placement, bool heavy);
+
+// "0-3,8,10-11" <-> {0, 1, 2, 3, 8, 10, 11}. CPU numbers an affinity mask
+// cannot hold (CPU_SETSIZE and up on Linux) make the list invalid.
+bool parseCpuList(const QString &text, QList<int> &cpus);
+
+QString formatCpuList(const QList<int> &cpus);
+
+// Pins the calling thread. Returns false where unsupported.
+bool setThreadAffinity(const QList<int> &cpus);
+
+// Lowers the calling thread's priority; on Linux, where nice is per thread,
+// threads created afterwards inherit it.
+bool setThreadNice(int nice);
+
+// Lowest nice level the calling process can give a thread that is at
+// current now. Unprivileged Linux processes cannot lower nice below
+// 20 - RLIMIT_NICE, so a thread that was niced cannot go back.
+int lowestThreadNice(int current);
+
+#endif // CPUPLACEMENT_H
@@ -0,0 +1,74 @@
+#include <QCheckBox>
+#include <QDialogButtonBox>
+#include <QFormLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QSpinBox>
+#include <QThread>
+#include <QVBoxLayout>
+#include <algorithm>
+#include "cpusettingsdialog.h"
+
+CpuSettingsDialog::CpuSettingsDialog(const int threads, const CpuPlacement &placement, QWidget *parent)
+    : QDialog(parent), threadsBox(new QSpinBox(this)), cpusEdit(new QLineEdit(this)), niceBox(new QSpinBox(this)),
+      performanceBox(new QCheckBox("Keep conversion on performance cores", this)) {
+    setWindowTitle("Threads and CPUs");
+    const CpuTopology &topology = cpuTopology();
+
+    threadsBox->setRange(0, 4 * QThread::idealThreadCount());
+    threadsBox->setSpecialValueText("Auto");
+    threadsBox->setValue(threads);
+    cpusEdit->setText(formatCpuList(placement.cpus));
+    cpusEdit->setPlaceholderText(QStringLiteral("All (%1)").arg(formatCpuList(topology.all())));
+    // Conversion threads already at placement.nice may not be allowed back
+    const int lowest_nice = std::clamp(lowestThreadNice(placement.nice), 0, 19);
+    niceBox->setRange(lowest_nice, 19);
+    niceBox->setValue(placement.nice);
+    niceBox->setToolTip(lowest_nice > 0
+                            ? QStringLiteral("Higher values leave more CPU time to other applications; "
+                                             "this process is not allowed below %1").arg(lowest_nice)
+                            : QStringLiteral("Higher values leave more CPU time to other applications"));
+    performanceBox->setChecked(placement.preferPerformanceCores);
+    performanceBox->setEnabled(topology.isHybrid());
+    performanceBox->setToolTip("Batch and interactive conversions use performance cores; "
+        "warm-up and background work use efficiency cores");
+
+    auto *form = new QFormLayout;
+    form->addRow("Threads:", threadsBox);
+    form->addRow("CPUs:", cpusEdit);
+    form->addRow("Nice level:", niceBox);
+    form->addRow(performanceBox);
+    form->addRow("Performance cores:", new QLabel(formatCpuList(topology.performance), this));
+    form->addRow("Efficiency cores:",
+                 new QLabel(topology.isHybrid() ? formatCpuList(topology.efficiency) : QStringLiteral("none"), this));
+
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, this);
+    connect(buttons, &QDialogButtonBox::accepted, this, &CpuSettingsDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(form);
+    layout->addWidget(buttons);
+}
+
+int CpuSettingsDialog::threads() const {
+    return threadsBox->value();
+}
+
+CpuPlacement CpuSettingsDialog::placement() const {
+    CpuPlacement placement;
+    parseCpuList(cpusEdit->text(), placement.cpus);
+    placement.nice = niceBox->value();
+    placement.preferPerformanceCores = performanceBox->isChecked();
+    return placement;
+}
+
+void CpuSettingsDialog::accept() {
+    QList<int> cpus;
+    if (!parseCpuList(cpusEdit->text(), cpus)) {
+        QMessageBox::warning(this, windowTitle(), "CPUs must be a list such as 0-3,8 (empty for all).");
+        return;
+    }
+    QDialog::accept();
+}
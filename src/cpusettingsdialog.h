@@ -0,0 +1,32 @@
+#ifndef CPUSETTINGSDIALOG_H
+#define CPUSETTINGSDIALOG_H
+
+#include <QDialog>
+#include "cpuplacement.h"
+
+class QCheckBox;
+class QLineEdit;
+class QSpinBox;
+
+// Options > Threads and CPUs: conversion thread count (0 = one per CPU) and
+// the CpuPlacement of conversion threads, with the detected core types.
+class CpuSettingsDialog : public QDialog {
+Q_OBJECT
+
+public:
+    CpuSettingsDialog(int threads, const CpuPlacement &placement, QWidget *parent = nullptr);
+
+    int threads() const;
+
+    CpuPlacement placement() const;
+
+    void accept() override;
+
+private:
+    QSpinBox *threadsBox;
+    QLineEdit *cpusEdit;
+    QSpinBox *niceBox;
+    QCheckBox *performanceBox;
+};
+
+#endif // CPUSETTINGSDIALOG_H
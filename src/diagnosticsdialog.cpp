@@ -0,0 +1,93 @@
+#include <QDialogButtonBox>
+#include <QFontDatabase>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <algorithm>
+#include "diagnosticsdialog.h"
+#include "calibration.h"
+#include "convertermanager.h"
+#include "responsivenessmonitor.h"
+#include "startupprofiler.h"
+
+namespace {
+    constexpr int histogram_width = 30;
+
+    QString converterSection() {
+        const ConverterManager &manager = ConverterManager::instance();
+        QString section;
+        section += QStringLiteral("Backend:         %1\n").arg(manager.backendName());
+        section += QStringLiteral("Loaded:          %1\n").arg(manager.isLoaded() ? "yes" : "no");
+        section += QStringLiteral("Idle:            %1 s\n").arg(manager.idleMsec() / 1000);
+        section += QStringLiteral("Resident:        %1 MiB\n")
+                .arg(static_cast<double>(ConverterManager::residentBytes()) / (1024 * 1024), 0, 'f', 1);
+        const double pressure = ConverterManager::memoryPressure();
+        section += QStringLiteral("Memory pressure: %1\n")
+                .arg(pressure < 0 ? QStringLiteral("n/a") : QStringLiteral("%1%").arg(pressure, 0, 'f', 2));
+        section += QStringLiteral("Most used:       %1\n\n").arg(manager.mostUsed(5).join(", "));
+        section += manager.events().join('\n');
+        return section;
+    }
+
+    QString responsivenessSection() {
+        const ResponsivenessMonitor &monitor = ResponsivenessMonitor::instance();
+        if (monitor.thresholdMsec() <= 0) {
+            return QStringLiteral("Off\n");
+        }
+        const QList<qint64> counts = monitor.histogram();
+        const QList<qint64> bounds = monitor.bucketBounds();
+        qint64 total = 0;
+        qint64 most = 0;
+        for (const qint64 count: counts) {
+            total += count;
+            most = std::max(most, count);
+        }
+        QString section;
+        section += QStringLiteral("Threshold:       %1 ms\n").arg(monitor.thresholdMsec());
+        section += QStringLiteral("Stalls:          %1, longest %2 ms\n\n").arg(total)
+                .arg(monitor.longestStallMsec());
+        for (qsizetype i = 0; i < counts.size(); ++i) {
+            const QString range = i + 1 < bounds.size()
+                                      ? QStringLiteral("%1-%2 ms").arg(bounds[i]).arg(bounds[i + 1])
+                                      : QStringLiteral(">= %1 ms").arg(bounds[i]);
+            const auto bar = static_cast<int>(most > 0 ? counts[i] * histogram_width / most : 0);
+            section += QStringLiteral("%1 %2 %3\n").arg(range, -16).arg(QString(bar, '#'), -histogram_width)
+                    .arg(counts[i]);
+        }
+        const QList<ResponsivenessMonitor::Stall> stalls = monitor.recentStalls();
+        if (!stalls.isEmpty()) {
+            section += "\nRecent stalls:\n";
+        }
+        for (const ResponsivenessMonitor::Stall &stall: stalls) {
+            section += QStringLiteral("%1 %2 ms  %3\n").arg(stall.time.toString("hh:mm:ss"))
+                    .arg(stall.msec, 6).arg(stall.activity);
+        }
+        return section;
+    }
+}
+
+DiagnosticsDialog::DiagnosticsDialog(QWidget *parent) : QDialog(parent), text(new QPlainTextEdit(this)) {
+    setWindowTitle("Diagnostics");
+    resize(640, 480);
+    text->setReadOnly(true);
+    text->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    const QPushButton *refresh_button = buttons->addButton("Refresh", QDialogButtonBox::ActionRole);
+    connect(refresh_button, &QPushButton::clicked, this, &DiagnosticsDialog::refresh);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(text);
+    layout->addWidget(buttons);
+    refresh();
+}
+
+void DiagnosticsDialog::refresh() const {
+    QString report;
+    report += "== Start-up ==\n" + startupReport() + "\n";
+    report += "== Converter ==\n" + converterSection() + "\n";
+    report += "== Calibration ==\n" + formatCalibration(cachedCalibration().value_or(Calibration())) + "\n";
+    report += "== Responsiveness ==\n" + responsivenessSection() + "\n";
+    text->setPlainText(report);
+}
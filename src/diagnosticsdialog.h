@@ -0,0 +1,23 @@
+#ifndef DIAGNOSTICSDIALOG_H
+#define DIAGNOSTICSDIALOG_H
+
+#include <QDialog>
+
+class QPlainTextEdit;
+
+// Help > Diagnostics: a read-only snapshot of start-up timings, the
+// converter's load / evict history, the host calibration and event-loop
+// stalls. Refresh takes a new snapshot.
+class DiagnosticsDialog : public QDialog {
+Q_OBJECT
+
+public:
+    explicit DiagnosticsDialog(QWidget *parent = nullptr);
+
+    void refresh() const;
+
+private:
+    QPlainTextEdit *text;
+};
+
+#endif // DIAGNOSTICSDIALOG_H
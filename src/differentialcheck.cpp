@@ -0,0 +1,278 @@
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <vector>
+#include "differentialcheck.h"
+#include "batchconverter.h"
+#include "compressedio.h"
+#include "convertermanager.h"
+#include "streamconverter.h"
+#include "textnormalizer.h"
+
+namespace {
+    // Building blocks of generated inputs: phrases with one-to-many
+    // mappings, both scripts, punctuation and line breaks (where chunks
+    // may split), and characters outside the BMP or needing composition
+    const char *const tokens[] = {
+        u8"简体中文转换为繁体中文", u8"頭髮", u8"发展", u8"理发", u8"乾燥", u8"天干地支", u8"计算机软件",
+        u8"計算機軟體", u8"皇后", u8"後面", u8"一干二净", u8"里程", u8"裡面", u8"香港", u8"臺灣", u8"台湾",
+        u8"，", u8"。", u8"！", u8"？", u8"「", u8"」", u8"“", u8"”", u8"、", u8"：", " ", "\n", "\r\n",
+        "hello", "2024", ".", ",", u8"𠀀", u8"𪚥", u8"😀", u8"é", u8"ＡＢＣ", u8"ｶﾀｶﾅ", u8"カタカナ"
+    };
+    // Stray continuation, truncated sequence, overlong, invalid byte and
+    // encoded surrogate
+    const char *const invalid_sequences[] = {"\x80", "\xE4\xB8", "\xC0\xAF", "\xFF", "\xED\xA0\x80"};
+
+    constexpr size_t small_chunk = 4096;
+    constexpr size_t stream_blocks[] = {64, 4096};
+    constexpr qint64 slow_floor_nsecs = 1000000;
+    // Inputs kept for mutation
+    constexpr int pool_size = 64;
+
+    class MemorySource : public ByteSource {
+    public:
+        explicit MemorySource(const std::string_view data) : rest(data) {
+        }
+
+        size_t read(char *data, const size_t size) override {
+            const size_t count = std::min(size, rest.size());
+            std::memcpy(data, rest.data(), count);
+            rest.remove_prefix(count);
+            return count;
+        }
+
+    private:
+        std::string_view rest;
+    };
+
+    class MemorySink : public ByteSink {
+    public:
+        bool write(const char *data, const size_t size) override {
+            output.append(data, size);
+            return true;
+        }
+
+        bool finish() override { return true; }
+
+        std::string output;
+    };
+
+    // Pushes in pieces of varying size, so blocks end at odd places
+    std::string convertStream(const IConverterBackend *converter, std::string_view input, const ZhoConfig config,
+                              const bool punctuation, const size_t block_size) {
+        StreamConverter stream(converter, config, punctuation, block_size);
+        std::string output;
+        size_t piece = 1;
+        while (!input.empty()) {
+            const size_t count = std::min(piece, input.size());
+            stream.push(input.substr(0, count), output);
+            input.remove_prefix(count);
+            piece = piece * 3 % (2 * block_size + 7) + 1;
+        }
+        stream.finish(output);
+        return output;
+    }
+
+    bool compare(const std::string &expected, const std::string &actual, const std::string &path,
+                 std::string &failure) {
+        if (expected == actual) {
+            return true;
+        }
+        const auto mismatch = std::mismatch(expected.begin(), expected.end(), actual.begin(), actual.end());
+        failure = path + " differs at byte " + std::to_string(mismatch.first - expected.begin()) + " (" +
+                  std::to_string(actual.size()) + " bytes, expected " + std::to_string(expected.size()) + ")";
+        return false;
+    }
+
+    std::string generate(QRandomGenerator &random, const int max_size) {
+        const int size = random.bounded(1, max_size + 1);
+        std::string input;
+        while (static_cast<int>(input.size()) < size) {
+            if (random.bounded(50) == 0) {
+                input += invalid_sequences[random.bounded(static_cast<int>(std::size(invalid_sequences)))];
+            } else {
+                input += tokens[random.bounded(static_cast<int>(std::size(tokens)))];
+            }
+        }
+        return input;
+    }
+
+    // One to four byte flips, token insertions, deletions, duplications or
+    // truncations
+    std::string mutate(QRandomGenerator &random, std::string input, const int max_size) {
+        const int count = random.bounded(1, 5);
+        for (int i = 0; i < count && !input.empty(); ++i) {
+            const auto at = static_cast<size_t>(random.bounded(static_cast<int>(input.size())));
+            const auto length = std::min(input.size() - at, static_cast<size_t>(random.bounded(1, 64)));
+            switch (random.bounded(5)) {
+                case 0:
+                    input[at] = static_cast<char>(input[at] ^ (1 << random.bounded(8)));
+                    break;
+                case 1:
+                    input.insert(at, tokens[random.bounded(static_cast<int>(std::size(tokens)))]);
+                    break;
+                case 2:
+                    input.erase(at, length);
+                    break;
+                case 3:
+                    if (static_cast<int>(input.size() + length) <= max_size) {
+                        input.insert(at, input.substr(at, length));
+                    }
+                    break;
+                default:
+                    input.resize(at);
+                    break;
+            }
+        }
+        std::replace(input.begin(), input.end(), '\0', ' ');
+        return input;
+    }
+
+    void saveInput(const QString &directory, const char *kind, const int index, const std::string &input) {
+        const QString path = QDir(directory).filePath(QStringLiteral("verify-%1-%2.txt").arg(kind).arg(index));
+        QFile file(path);
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(input.data(), static_cast<qint64>(input.size()));
+            std::printf("  saved %s\n", qPrintable(path));
+        }
+    }
+}
+
+bool verifyConversionPaths(const IConverterBackend *converter, std::string_view input, const ZhoConfig config,
+                           const bool punctuation, std::string &failure) {
+    input = input.substr(0, input.find('\0'));
+    const std::string text(input);
+    bool ok = false;
+    const std::string reference = zhoConvert(converter, text.c_str(), config, punctuation, &ok);
+    if (!ok) {
+        failure = "whole-text conversion failed";
+        return false;
+    }
+
+    std::string chunked;
+    if (!BatchConverter::convertText(converter, input, config, punctuation, chunked, small_chunk)) {
+        failure = "chunked conversion failed";
+        return false;
+    }
+    if (!compare(reference, chunked, "chunked", failure)) {
+        return false;
+    }
+
+    for (const size_t block_size: stream_blocks) {
+        if (!compare(reference, convertStream(converter, input, config, punctuation, block_size),
+                     "stream/" + std::to_string(block_size), failure)) {
+            return false;
+        }
+    }
+
+    MemorySource source(input);
+    MemorySink sink;
+    StreamConverter stream(converter, config, punctuation, small_chunk);
+    std::string error;
+    if (!pumpStream(source, sink, stream, true, error)) {
+        failure = "pipeline failed: " + error;
+        return false;
+    }
+    return compare(reference, sink.output, "pipeline", failure);
+}
+
+int runDifferentialCheck(const DifferentialCheckOptions &options) {
+    if (options.iterations <= 0 || options.maxSize <= 0) {
+        std::fprintf(stderr, "Invalid check options\n");
+        return 1;
+    }
+    const ConverterLease converter = sharedConverter();
+    if (!converter) {
+        std::fprintf(stderr, "zhoconv: %s\n", qPrintable(ConverterManager::instance().lastError()));
+        return 1;
+    }
+    setTextNormalization({});
+
+    const quint32 seed = options.seed != 0 ? options.seed : QRandomGenerator::global()->generate();
+    QRandomGenerator random(seed);
+    std::printf("Checking %d inputs up to %d bytes, config %s, seed %u\n", options.iterations, options.maxSize,
+                configName(options.config), seed);
+
+    std::vector<std::string> pool;
+    std::vector<double> nsecs_per_byte;
+    qint64 total_bytes = 0;
+    int failures = 0;
+    int slow = 0;
+    for (int i = 0; i < options.iterations; ++i) {
+        const std::string input = pool.empty() || random.bounded(2) == 0
+                                      ? generate(random, options.maxSize)
+                                      : mutate(random, pool[random.bounded(static_cast<int>(pool.size()))],
+                                               options.maxSize);
+        total_bytes += static_cast<qint64>(input.size());
+
+        QElapsedTimer timer;
+        timer.start();
+        zhoConvert(converter.get(), input.c_str(), options.config, options.punctuation);
+        const qint64 elapsed = timer.nsecsElapsed();
+
+        std::string failure;
+        if (!verifyConversionPaths(converter.get(), input, options.config, options.punctuation, failure)) {
+            ++failures;
+            std::printf("Input %d (%zu bytes): %s\n", i, input.size(), failure.c_str());
+            saveInput(options.directory, "failure", i, input);
+        }
+
+        // Conversion should be linear in the input; compare the time per
+        // byte with the median so far
+        if (input.size() >= 256) {
+            const double per_byte = static_cast<double>(elapsed) / static_cast<double>(input.size());
+            if (nsecs_per_byte.size() >= 32) {
+                std::vector<double> sorted = nsecs_per_byte;
+                const auto middle = sorted.begin() + static_cast<qsizetype>(sorted.size() / 2);
+                std::nth_element(sorted.begin(), middle, sorted.end());
+                if (elapsed > slow_floor_nsecs && per_byte > options.slowFactor * *middle) {
+                    ++slow;
+                    std::printf("Input %d (%zu bytes): slow, %.1f ns/byte against a median of %.1f\n", i,
+                                input.size(), per_byte, *middle);
+                    saveInput(options.directory, "slow", i, input);
+                }
+            }
+            nsecs_per_byte.push_back(per_byte);
+        }
+
+        if (static_cast<int>(pool.size()) < pool_size) {
+            pool.push_back(input);
+        } else {
+            pool[random.bounded(pool_size)] = input;
+        }
+        if ((i + 1) % 1000 == 0) {
+            std::printf("%d inputs, %d failures, %d slow\n", i + 1, failures, slow);
+        }
+    }
+    std::printf("%d inputs, %.1f MB, %d failures, %d slow (seed %u)\n", options.iterations,
+                static_cast<double>(total_bytes) / 1e6, failures, slow, seed);
+    return failures > 0 ? 1 : 0;
+}
+
+#ifdef ZHO_FUZZER
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, const size_t size) {
+    static const ConverterLease converter = [] {
+        setTextNormalization({});
+        ConverterLease lease = sharedConverter();
+        if (!lease) {
+            std::fprintf(stderr, "%s\n", qPrintable(ConverterManager::instance().lastError()));
+            std::abort();
+        }
+        return lease;
+    }();
+    std::string failure;
+    if (!verifyConversionPaths(converter.get(), {reinterpret_cast<const char *>(data), size}, ZhoConfig::S2t, false,
+                               failure)) {
+        std::fprintf(stderr, "%s\n", failure.c_str());
+        std::abort();
+    }
+    return 0;
+}
+#endif
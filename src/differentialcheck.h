@@ -0,0 +1,38 @@
+#ifndef DIFFERENTIALCHECK_H
+#define DIFFERENTIALCHECK_H
+
+#include <QString>
+#include <string>
+#include <string_view>
+#include "converterbackend.h"
+#include "zhoconfig.h"
+
+struct DifferentialCheckOptions {
+    int iterations = 10000;
+    quint32 seed = 0; // 0: from the clock
+    int maxSize = 64 * 1024;
+    ZhoConfig config = ZhoConfig::S2t;
+    bool punctuation = false;
+    // Inputs that fail or run slow are written here
+    QString directory = ".";
+    // Slow: this many times the median time per byte (and over 1 ms)
+    double slowFactor = 20;
+};
+
+// Converts input with every conversion path - BatchConverter::convertText()
+// at the smallest chunk size, StreamConverter with small blocks and ragged
+// pushes, and the pipelined pumpStream() - and compares each with plain
+// converter->convert() of the whole text. On a difference, names the path and the first
+// differing byte in failure and returns false. Input normalization must be
+// off (it is not applied to the reference). Input stops at its first NUL.
+bool verifyConversionPaths(const IConverterBackend *converter, std::string_view input, ZhoConfig config,
+                           bool punctuation, std::string &failure);
+
+// Standalone driver: feeds generated CJK / UTF-8 inputs, mutated copies of
+// earlier ones and invalid byte sequences to verifyConversionPaths(), and
+// flags inputs whose conversion takes far longer per byte than the rest.
+// The zhoconv_fuzz target (CMake option ZHO_FUZZER) builds this file with
+// a libFuzzer entry point running the same check. Returns a process exit code.
+int runDifferentialCheck(const DifferentialCheckOptions &options);
+
+#endif // DIFFERENTIALCHECK_H
@@ -0,0 +1,66 @@
+#include <QFile>
+#include <algorithm>
+#include "filewriter.h"
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr size_t write_block_size = 1024 * 1024;
+    // Small files fit into a single extent anyway
+    constexpr size_t preallocate_threshold = 64 * 1024;
+}
+
+bool writeWholeFile(const QString &path, const std::string_view data) {
+#ifdef Q_OS_LINUX
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+        return false;
+    }
+    const int fd = file.handle();
+
+    const auto size = static_cast<off_t>(data.size());
+    if (data.size() >= preallocate_threshold) {
+        // Best effort: not every filesystem supports fallocate
+        const off_t reserved = (size + write_block_size - 1) / write_block_size * write_block_size;
+        fallocate(fd, 0, 0, reserved);
+    }
+
+    for (size_t offset = 0; offset < data.size();) {
+        const size_t length = std::min(write_block_size, data.size() - offset);
+        const ssize_t written = ::pwrite(fd, data.data() + offset, length, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        offset += static_cast<size_t>(written);
+    }
+    // Drop the rounded-up preallocation tail
+    return ::ftruncate(fd, size) == 0;
+#else
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    for (size_t offset = 0; offset < data.size(); offset += write_block_size) {
+        const size_t length = std::min(write_block_size, data.size() - offset);
+        if (file.write(data.data() + offset, static_cast<qint64>(length)) != static_cast<qint64>(length)) {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+void dropPageCache([[maybe_unused]] const int fd) {
+#ifdef Q_OS_LINUX
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+#endif
+}
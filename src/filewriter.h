@@ -0,0 +1,19 @@
+#ifndef FILEWRITER_H
+#define FILEWRITER_H
+
+#include <QString>
+#include <string_view>
+
+// Writes the complete contents of an output file whose size is known up
+// front. On Linux the file is preallocated (rounded up to whole blocks) so
+// large outputs get contiguous extents, written in large block-aligned
+// chunks and truncated to its exact size at the end. Elsewhere it is a plain
+// text-mode write.
+bool writeWholeFile(const QString &path, std::string_view data);
+
+// Tells the kernel the caller is done with this file's cached pages, so a
+// large batch does not evict everyone else's working set. No-op where
+// posix_fadvise is not available.
+void dropPageCache(int fd);
+
+#endif // FILEWRITER_H
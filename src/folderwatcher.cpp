@@ -0,0 +1,261 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSocketNotifier>
+#include <algorithm>
+#include "folderwatcher.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FolderWatcher::FolderWatcher(QObject *parent) : QObject(parent) {
+    debounceTimer.setSingleShot(true);
+    connect(&debounceTimer, &QTimer::timeout, this, &FolderWatcher::flushPending);
+}
+
+FolderWatcher::~FolderWatcher() {
+    stop();
+}
+
+bool FolderWatcher::start(const QString &directory) {
+    stop();
+    const QDir dir(directory);
+    if (!dir.exists()) {
+        return false;
+    }
+    watchedDir = dir.absolutePath();
+
+#ifdef Q_OS_LINUX
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0) {
+        inotifyNotifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+        connect(inotifyNotifier, &QSocketNotifier::activated, this, &FolderWatcher::readInotifyEvents);
+    }
+    if (inotifyFd < 0)
+#endif
+    {
+        fsWatcher = new QFileSystemWatcher(this);
+        connect(fsWatcher, &QFileSystemWatcher::directoryChanged, this, &FolderWatcher::onDirectoryChanged);
+    }
+
+    scanDirectory(watchedDir, true);
+    return true;
+}
+
+void FolderWatcher::stop() {
+    debounceTimer.stop();
+    burstTimer.invalidate();
+#ifdef Q_OS_LINUX
+    delete inotifyNotifier;
+    inotifyNotifier = nullptr;
+    if (inotifyFd >= 0) {
+        ::close(inotifyFd);
+        inotifyFd = -1;
+    }
+    inotifyDirs.clear();
+#endif
+    delete fsWatcher;
+    fsWatcher = nullptr;
+    watchedDir.clear();
+    watchedDirs.clear();
+    snapshot.clear();
+    candidates.clear();
+    ready.clear();
+}
+
+bool FolderWatcher::isActive() const {
+    return !watchedDir.isEmpty();
+}
+
+QString FolderWatcher::directory() const {
+    return watchedDir;
+}
+
+void FolderWatcher::setDebounceInterval(const int msec) {
+    debounceInterval = msec;
+}
+
+void FolderWatcher::setMaxLatency(const int msec) {
+    maxLatency = msec;
+}
+
+FolderWatcher::FileState FolderWatcher::stat(const QString &path) {
+    const QFileInfo info(path);
+    if (!info.exists()) {
+        return {};
+    }
+    return {info.size(), info.lastModified()};
+}
+
+bool FolderWatcher::isIgnored(const QString &file_name) {
+    // Hidden files and the usual partial-download / editor temp names; their
+    // writers rename them into place when done, which we see as a new file.
+    return file_name.startsWith('.') ||
+           file_name.endsWith('~') ||
+           file_name.endsWith(".tmp", Qt::CaseInsensitive) ||
+           file_name.endsWith(".part", Qt::CaseInsensitive) ||
+           file_name.endsWith(".crdownload", Qt::CaseInsensitive) ||
+           file_name.endsWith(".swp", Qt::CaseInsensitive);
+}
+
+void FolderWatcher::watchDirectory(const QString &path) {
+    if (watchedDirs.contains(path)) {
+        return;
+    }
+#ifdef Q_OS_LINUX
+    if (inotifyFd >= 0) {
+        const int wd = inotify_add_watch(inotifyFd, QFile::encodeName(path).constData(),
+                                         IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+        if (wd < 0) {
+            return;
+        }
+        inotifyDirs.insert(wd, path);
+        watchedDirs.insert(path);
+        return;
+    }
+#endif
+    if (fsWatcher->addPath(path)) {
+        watchedDirs.insert(path);
+    }
+}
+
+void FolderWatcher::scanDirectory(const QString &path, const bool initial) {
+    watchDirectory(path);
+
+    const QFileInfoList entries = QDir(path).entryInfoList(
+        QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+    for (const QFileInfo &entry: entries) {
+        const QString entry_path = entry.absoluteFilePath();
+        if (entry.isDir()) {
+            if (!watchedDirs.contains(entry_path)) {
+                scanDirectory(entry_path, initial);
+            }
+            continue;
+        }
+        if (isIgnored(entry.fileName())) {
+            continue;
+        }
+        const FileState state{entry.size(), entry.lastModified()};
+        if (initial) {
+            snapshot.insert(entry_path, state);
+        } else if (!(snapshot.value(entry_path) == state) && !ready.contains(entry_path)) {
+            addCandidate(entry_path);
+        }
+    }
+}
+
+void FolderWatcher::onDirectoryChanged(const QString &path) {
+    if (!QDir(path).exists()) {
+        watchedDirs.remove(path);
+        return;
+    }
+    scanDirectory(path, false);
+}
+
+void FolderWatcher::addCandidate(const QString &path) {
+    candidates.insert(path, stat(path));
+    schedule();
+}
+
+void FolderWatcher::addReady(const QString &path) {
+    candidates.remove(path);
+    ready.insert(path);
+    schedule();
+}
+
+void FolderWatcher::schedule() {
+    // Restart the quiet period on every event, but never push a pending file
+    // past maxLatency, so a steady stream of events cannot starve the output.
+    if (!burstTimer.isValid()) {
+        burstTimer.start();
+    }
+    const qint64 remaining = std::max<qint64>(0, maxLatency - burstTimer.elapsed());
+    debounceTimer.start(static_cast<int>(std::min<qint64>(debounceInterval, remaining)));
+}
+
+void FolderWatcher::flushPending() {
+    for (auto it = candidates.begin(); it != candidates.end();) {
+        const FileState current = stat(it.key());
+        if (current.size < 0) {
+            it = candidates.erase(it);
+            continue;
+        }
+        if (current == it.value()) {
+            if (QFile file(it.key()); file.open(QIODevice::ReadOnly)) {
+                ready.insert(it.key());
+                it = candidates.erase(it);
+                continue;
+            }
+        }
+        // Still growing (or locked by its writer): check again next round.
+        it.value() = current;
+        ++it;
+    }
+
+    QStringList files;
+    files.reserve(ready.size());
+    for (const QString &path: std::as_const(ready)) {
+        if (const FileState state = stat(path); state.size >= 0) {
+            snapshot.insert(path, state);
+            files.append(path);
+        }
+    }
+    ready.clear();
+
+    burstTimer.invalidate();
+    if (!candidates.isEmpty()) {
+        schedule();
+    }
+    if (!files.isEmpty()) {
+        files.sort();
+        emit filesReady(files);
+    }
+}
+
+#ifdef Q_OS_LINUX
+void FolderWatcher::readInotifyEvents() {
+    alignas(inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        const ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                // Events were dropped; fall back to comparing against the snapshot.
+                scanDirectory(watchedDir, false);
+                continue;
+            }
+            const QString dir = inotifyDirs.value(event->wd);
+            if (dir.isEmpty()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                inotifyDirs.remove(event->wd);
+                watchedDirs.remove(dir);
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+            const QString name = QFile::decodeName(event->name);
+            const QString path = dir + '/' + name;
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    scanDirectory(path, false);
+                }
+                continue;
+            }
+            if (!isIgnored(name) && (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) {
+                addReady(path);
+            }
+        }
+    }
+}
+#endif
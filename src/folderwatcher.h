@@ -0,0 +1,96 @@
+#ifndef FOLDERWATCHER_H
+#define FOLDERWATCHER_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+class QFileSystemWatcher;
+class QSocketNotifier;
+
+// Watches a directory tree and reports files that were created or modified
+// once they are no longer being written. Bursts of events are coalesced into
+// a single filesReady() per debounce window.
+//
+// On Linux the watcher listens to inotify directly, so a file becomes ready as
+// soon as its writer closes it (IN_CLOSE_WRITE) or it is moved in. Elsewhere
+// QFileSystemWatcher is used and a file is ready once its size and timestamp
+// stay unchanged for one debounce interval and it can be opened for reading.
+class FolderWatcher : public QObject {
+Q_OBJECT
+
+public:
+    explicit FolderWatcher(QObject *parent = nullptr);
+
+    ~FolderWatcher() override;
+
+    bool start(const QString &directory);
+
+    void stop();
+
+    bool isActive() const;
+
+    QString directory() const;
+
+    // Quiet period after the last event before pending files are reported.
+    void setDebounceInterval(int msec);
+
+    // Upper bound on how long a file may wait while events keep arriving.
+    void setMaxLatency(int msec);
+
+signals:
+    void filesReady(const QStringList &files);
+
+private slots:
+    void onDirectoryChanged(const QString &path);
+
+    void flushPending();
+
+private:
+    struct FileState {
+        qint64 size = -1;
+        QDateTime modified;
+
+        bool operator==(const FileState &other) const {
+            return size == other.size && modified == other.modified;
+        }
+    };
+
+    static FileState stat(const QString &path);
+
+    static bool isIgnored(const QString &file_name);
+
+    void scanDirectory(const QString &path, bool initial);
+
+    void watchDirectory(const QString &path);
+
+    void addCandidate(const QString &path);
+
+    void addReady(const QString &path);
+
+    void schedule();
+
+#ifdef Q_OS_LINUX
+    void readInotifyEvents();
+
+    int inotifyFd = -1;
+    QSocketNotifier *inotifyNotifier = nullptr;
+    QHash<int, QString> inotifyDirs;
+#endif
+
+    QFileSystemWatcher *fsWatcher = nullptr;
+    QString watchedDir;
+    QSet<QString> watchedDirs;
+    QHash<QString, FileState> snapshot;
+    QHash<QString, FileState> candidates;
+    QSet<QString> ready;
+    QTimer debounceTimer;
+    QElapsedTimer burstTimer;
+    int debounceInterval = 200;
+    int maxLatency = 1000;
+};
+
+#endif // FOLDERWATCHER_H
@@ -0,0 +1,191 @@
+#include <QApplication>
+#include <QCheckBox>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QKeyEvent>
+#include <QLineEdit>
+#include <QMainWindow>
+#include <QPlainTextEdit>
+#include <QRadioButton>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include "guibenchmark.h"
+#include "batchconverter.h"
+#include "convertermanager.h"
+#include "resultstore.h"
+
+namespace {
+    const QByteArray sample_line = QByteArray(u8"简体中文转换为繁体中文，这是一个测试句子。計算機軟體與頭髮的轉換。\n");
+    constexpr int heartbeat_msec = 1;
+    // Kept running after a step is done, for the layout and painting it
+    // left behind
+    constexpr int settle_msec = 200;
+
+    struct StepResult {
+        double wallMsec = 0;
+        double stallMsec = 0;
+        qint64 growthBytes = 0;
+        std::vector<double> gaps;
+    };
+
+    // Runs action from the event loop and keeps the loop going until done()
+    // holds, then settle_msec more. A 1 ms heartbeat on the GUI thread
+    // records the gaps between its ticks and the resident memory peak.
+    StepResult runStep(const std::function<void()> &action, const std::function<bool()> &done) {
+        StepResult result;
+        const qint64 base_bytes = ConverterManager::residentBytes();
+        qint64 peak_bytes = base_bytes;
+        QElapsedTimer clock;
+        QElapsedTimer wall;
+        qint64 last_beat = 0;
+        bool finished = false;
+        QEventLoop loop;
+        QTimer heartbeat;
+        heartbeat.setTimerType(Qt::PreciseTimer);
+        heartbeat.setInterval(heartbeat_msec);
+        QObject::connect(&heartbeat, &QTimer::timeout, &loop, [&] {
+            const qint64 now = clock.nsecsElapsed();
+            result.gaps.push_back(static_cast<double>(now - last_beat) / 1e6);
+            last_beat = now;
+            peak_bytes = std::max(peak_bytes, ConverterManager::residentBytes());
+            if (!finished && wall.isValid() && done()) {
+                finished = true;
+                result.wallMsec = static_cast<double>(wall.nsecsElapsed()) / 1e6;
+                QTimer::singleShot(settle_msec, &loop, &QEventLoop::quit);
+            }
+        });
+        clock.start();
+        heartbeat.start();
+        QTimer::singleShot(0, &loop, [&] {
+            wall.start();
+            action();
+        });
+        loop.exec();
+        heartbeat.stop();
+
+        result.stallMsec = result.gaps.empty() ? 0 : *std::max_element(result.gaps.begin(), result.gaps.end());
+        result.growthBytes = peak_bytes - base_bytes;
+        return result;
+    }
+
+    void report(const char *name, const StepResult &result, const QString &workload, const qint64 bytes,
+                QList<GuiStepResult> *steps) {
+        std::printf("%-12s %10.1f %10.1f %10.1f\n", name, result.wallMsec, result.stallMsec,
+                    static_cast<double>(result.growthBytes) / (1024 * 1024));
+        const double mb_per_second = bytes > 0 && result.wallMsec > 0
+                                         ? static_cast<double>(bytes) / 1e6 / (result.wallMsec / 1000)
+                                         : 0;
+        appendResult("bench-gui", name, ZhoConfig::S2t, workload, mb_per_second, result.gaps);
+        if (steps != nullptr) {
+            steps->append({name, result.wallMsec, result.stallMsec, result.growthBytes});
+        }
+    }
+
+    bool writeFile(const QString &path, const QByteArray &content) {
+        QFile file(path);
+        return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+    }
+}
+
+int runGuiBenchmark(QMainWindow &window, const GuiBenchmarkOptions &options, QList<GuiStepResult> *steps) {
+    if (options.textSize <= 0 || options.keystrokes <= 0 || options.batchFiles <= 0 || options.batchFileSize <= 0) {
+        std::fprintf(stderr, "Invalid benchmark options\n");
+        return 1;
+    }
+    auto *source = window.findChild<QPlainTextEdit *>("tbSource");
+    auto *s2t_button = window.findChild<QRadioButton *>("rbS2t");
+    auto *standard_button = window.findChild<QRadioButton *>("rbStd");
+    auto *punctuation_box = window.findChild<QCheckBox *>("cbPunctuation");
+    if (source == nullptr || s2t_button == nullptr || standard_button == nullptr || punctuation_box == nullptr) {
+        std::fprintf(stderr, "Not the converter's main window\n");
+        return 1;
+    }
+
+    QTemporaryDir temporary;
+    const QString root = (options.directory.isEmpty() ? temporary.path() : options.directory) + "/gui";
+    QDir().mkpath(root + "/batch/in");
+    QDir().mkpath(root + "/batch/out");
+    QByteArray text;
+    while (text.size() + sample_line.size() <= options.textSize) {
+        text += sample_line;
+    }
+    QByteArray small;
+    while (small.size() + sample_line.size() <= options.batchFileSize) {
+        small += sample_line;
+    }
+    const QString text_file = root + "/source.txt";
+    QStringList batch_files;
+    bool written = writeFile(text_file, text);
+    for (int i = 0; i < options.batchFiles && written; ++i) {
+        batch_files.append(QStringLiteral("%1/batch/in/%2.txt").arg(root).arg(i, 5, 10, QChar('0')));
+        written = writeFile(batch_files.last(), small);
+    }
+    if (!written) {
+        std::fprintf(stderr, "Cannot write the benchmark inputs below %s\n", qPrintable(root));
+        return 1;
+    }
+
+    // s2t without punctuation, whatever the settings say
+    s2t_button->setChecked(true);
+    standard_button->setChecked(true);
+    punctuation_box->setChecked(false);
+
+    std::printf("Text %.1f MB, %d keystrokes, batch %d x %d bytes, platform %s\n",
+                static_cast<double>(text.size()) / 1e6, options.keystrokes, options.batchFiles,
+                static_cast<int>(small.size()), qPrintable(QGuiApplication::platformName()));
+    std::printf("%-12s %10s %10s %10s\n", "step", "wall ms", "stall ms", "RSS +MiB");
+    const QString text_workload = fileWorkload(1, text.size());
+
+    // setPlainText(), then the script check and the character count
+    report("open file", runStep([&] {
+        QMetaObject::invokeMethod(&window, "openFiles", Q_ARG(QStringList, QStringList{text_file}));
+    }, [] { return true; }), text_workload, text.size(), steps);
+
+    // Each key press changes the document, which runs textChanged slots
+    // on the whole text
+    source->moveCursor(QTextCursor::End);
+    const int target_chars = source->document()->characterCount() + options.keystrokes;
+    report("type", runStep([&] {
+        for (int i = 0; i < options.keystrokes; ++i) {
+            QCoreApplication::postEvent(source, new QKeyEvent(QEvent::KeyPress, 0, Qt::NoModifier, u8"字"));
+        }
+    }, [&] { return source->document()->characterCount() >= target_chars; }),
+           QStringLiteral("%1 keys into %2").arg(options.keystrokes).arg(text_workload), 0, steps);
+
+    // toPlainText(), conversion on the GUI thread and setPlainText() of
+    // the result
+    report("convert", runStep([&] {
+        QMetaObject::invokeMethod(&window, "on_btnProcess_clicked");
+    }, [] { return true; }), text_workload, text.size(), steps);
+
+    // Building the Batch tab on first show, then one appendPlainText() per
+    // finished file
+    QMetaObject::Connection connection;
+    bool batch_done = false;
+    report("batch", runStep([&] {
+        QMetaObject::invokeMethod(&window, "openFiles", Q_ARG(QStringList, batch_files));
+        if (auto *out_dir_edit = window.findChild<QLineEdit *>("lineEditDir")) {
+            out_dir_edit->setText(root + "/batch/out");
+        }
+        QMetaObject::invokeMethod(&window, "on_btnProcess_clicked");
+        // Connected after the window's own handler, so the final log
+        // lines are in when this runs
+        const auto *batch = window.findChild<BatchConverter *>();
+        if (batch != nullptr && batch->isRunning()) {
+            connection = QObject::connect(batch, &BatchConverter::finished, &window, [&] { batch_done = true; });
+        }
+    }, [&] { return batch_done || !connection; }), fileWorkload(options.batchFiles, small.size()),
+           static_cast<qint64>(small.size()) * options.batchFiles, steps);
+    QObject::disconnect(connection);
+    if (!batch_done) {
+        std::fprintf(stderr, "The batch did not start\n");
+        return 1;
+    }
+    return 0;
+}
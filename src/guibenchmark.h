@@ -0,0 +1,40 @@
+#ifndef GUIBENCHMARK_H
+#define GUIBENCHMARK_H
+
+#include <QList>
+#include <QString>
+
+class QMainWindow;
+
+struct GuiBenchmarkOptions {
+    // Generated inputs go below this directory; empty: a temporary one
+    QString directory;
+    int textSize = 8 * 1024 * 1024;
+    int keystrokes = 200;
+    int batchFiles = 2000;
+    int batchFileSize = 4096;
+};
+
+// One step as printed
+struct GuiStepResult {
+    QString name;
+    double wallMsec = 0;
+    double stallMsec = 0;
+    qint64 growthBytes = 0;
+};
+
+// Drives the main window through its slots the way a user would, on large
+// inputs: open a file into the source box, type into it, convert it, and
+// run a batch whose log fills the preview box. Prints, per step, the wall
+// time, the longest event-loop stall (gap between 1 ms heartbeats, which
+// includes layout and painting after the slot returns) and the growth of
+// resident memory, and appends each step to the results store as
+// "bench-gui" with the heartbeat gaps as latency samples.
+//
+// Used by `ZhoConverterQt --gui-benchmark`, which runs on the offscreen
+// platform unless QT_QPA_PLATFORM is set, so it works on headless machines.
+// Returns a process exit code; with steps, also fills it in, for
+// tests/guitest.cpp to hold against its budgets.
+int runGuiBenchmark(QMainWindow &window, const GuiBenchmarkOptions &options, QList<GuiStepResult> *steps = nullptr);
+
+#endif // GUIBENCHMARK_H
@@ -0,0 +1,249 @@
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "iobenchmark.h"
+#include "batchconverter.h"
+#include "convertermanager.h"
+#include "resultstore.h"
+#include "uringbatchio.h"
+#include "zhoutilities.h"
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    struct RunResult {
+        double seconds = 0;
+        uint64_t files = 0;
+        uint64_t bytes = 0;
+        uint64_t syscalls = 0;
+    };
+
+    void printResult(const char *name, const RunResult &result, const IoBenchmarkOptions &options) {
+        const double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+        appendResult("bench-io", options.convert ? QString(name) : QString(name) + ", I/O only", options.config,
+                     fileWorkload(options.files, options.fileSize), static_cast<double>(result.bytes) / seconds / 1e6);
+        std::printf("%-24s %10.0f files/s %9.1f MB/s", name, static_cast<double>(result.files) / seconds,
+                    static_cast<double>(result.bytes) / seconds / 1e6);
+        if (result.syscalls > 0 && result.files > 0) {
+            std::printf(" %7.2f syscalls/file", static_cast<double>(result.syscalls) / result.files);
+        }
+        std::printf("\n");
+    }
+
+    // 1000 files per directory keeps directory lookups cheap at 1M files.
+    QString corpusPath(const QString &root, const char *side, const int index) {
+        return QStringLiteral("%1/%2/%3/%4.txt")
+                .arg(root, side)
+                .arg(index / 1000, 4, 10, QChar('0'))
+                .arg(index % 1000, 3, 10, QChar('0'));
+    }
+
+    bool generateCorpus(const IoBenchmarkOptions &options) {
+        if (QFile::exists(corpusPath(options.directory, "in", options.files - 1))) {
+            return true;
+        }
+        std::printf("Generating %d files of %d bytes ...\n", options.files, options.fileSize);
+        const QByteArray sample = QByteArray(u8"简体中文转换为繁体中文，这是一个测试句子。\n");
+        QByteArray content;
+        while (content.size() < options.fileSize) {
+            content += sample;
+        }
+        content.truncate(static_cast<qsizetype>(find_max_utf8_length(
+            std::string_view(content.constData(), content.size()), options.fileSize)));
+
+        for (int i = 0; i < options.files; ++i) {
+            if (i % 1000 == 0) {
+                QDir().mkpath(QFileInfo(corpusPath(options.directory, "in", i)).absolutePath());
+                QDir().mkpath(QFileInfo(corpusPath(options.directory, "out", i)).absolutePath());
+            }
+            QFile file(corpusPath(options.directory, "in", i));
+            if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size()) {
+                std::fprintf(stderr, "Cannot write %s\n", qPrintable(file.fileName()));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::string convertText(const IConverterBackend *converter, const std::string &text, const ZhoConfig config,
+                            const bool convert) {
+        if (!convert) {
+            return text;
+        }
+        return zhoConvert(converter, text.c_str(), config, false);
+    }
+
+#ifdef Q_OS_LINUX
+    RunResult runPosix(const std::vector<std::string> &inputs, const std::vector<std::string> &outputs,
+                       const IConverterBackend *converter, const ZhoConfig config, const bool convert) {
+        RunResult result;
+        QElapsedTimer timer;
+        timer.start();
+        std::string text;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            const int in = ::open(inputs[i].c_str(), O_RDONLY | O_CLOEXEC);
+            ++result.syscalls;
+            if (in < 0) {
+                continue;
+            }
+            struct stat info{};
+            ::fstat(in, &info);
+            text.resize(static_cast<size_t>(info.st_size));
+            const ssize_t length = ::read(in, text.data(), text.size());
+            ::close(in);
+            result.syscalls += 3;
+            if (length < 0) {
+                continue;
+            }
+            text.resize(static_cast<size_t>(length));
+
+            const std::string converted = convertText(converter, text, config, convert);
+            const int out = ::open(outputs[i].c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            ++result.syscalls;
+            if (out < 0) {
+                continue;
+            }
+            const bool written = ::write(out, converted.data(), converted.size()) ==
+                                 static_cast<ssize_t>(converted.size());
+            ::close(out);
+            result.syscalls += 2;
+            if (written) {
+                ++result.files;
+                result.bytes += text.size();
+            }
+        }
+        result.seconds = static_cast<double>(timer.nsecsElapsed()) / 1e9;
+        return result;
+    }
+
+    RunResult runUring(const std::vector<std::string> &inputs, const std::vector<std::string> &outputs,
+                       const IConverterBackend *converter, const ZhoConfig config, const bool convert) {
+        RunResult result;
+        UringBatchIO io;
+        if (!io.isValid()) {
+            return result;
+        }
+        QElapsedTimer timer;
+        timer.start();
+        std::vector<UringReadResult> reads;
+        std::vector<std::string> converted;
+        std::vector<UringWriteRequest> writes;
+        std::vector<int> errors;
+        for (size_t offset = 0; offset < inputs.size(); offset += io.depth()) {
+            const size_t count = std::min<size_t>(io.depth(), inputs.size() - offset);
+            const std::vector<std::string> batch(inputs.begin() + static_cast<ptrdiff_t>(offset),
+                                                 inputs.begin() + static_cast<ptrdiff_t>(offset + count));
+            io.readBatch(batch, reads);
+
+            converted.assign(count, {});
+            writes.clear();
+            for (size_t i = 0; i < count; ++i) {
+                if (reads[i].error == 0) {
+                    converted[i] = convertText(converter, reads[i].data, config, convert);
+                    writes.push_back({outputs[offset + i], converted[i]});
+                    result.bytes += reads[i].data.size();
+                }
+            }
+            io.writeBatch(writes, errors);
+            for (const int error: errors) {
+                if (error == 0) {
+                    ++result.files;
+                }
+            }
+        }
+        result.seconds = static_cast<double>(timer.nsecsElapsed()) / 1e9;
+        result.syscalls = io.stats().syscalls;
+        return result;
+    }
+#endif
+
+    RunResult runBatchConverter(const QList<BatchConverter::Job> &jobs, const ZhoConfig config,
+                                const BatchConverter::IoBackend backend, const uint64_t bytes) {
+        RunResult result;
+        BatchConverter converter;
+        converter.setIoBackend(backend);
+        QEventLoop loop;
+        QObject::connect(&converter, &BatchConverter::fileFinished, &loop,
+                         [&result](int, const QString &, const QString &, const BatchConverter::Status status) {
+                             if (status == BatchConverter::Done) {
+                                 ++result.files;
+                             }
+                         });
+        QObject::connect(&converter, &BatchConverter::finished, &loop, &QEventLoop::quit);
+
+        QElapsedTimer timer;
+        timer.start();
+        converter.start(jobs, config, false);
+        loop.exec();
+        result.seconds = static_cast<double>(timer.nsecsElapsed()) / 1e9;
+        result.bytes = bytes;
+        return result;
+    }
+}
+
+int runIoBenchmark(const IoBenchmarkOptions &options) {
+    if (options.files <= 0 || options.fileSize <= 0 || !QDir().mkpath(options.directory)) {
+        std::fprintf(stderr, "Invalid benchmark options\n");
+        return 1;
+    }
+    if (!generateCorpus(options)) {
+        return 1;
+    }
+
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    QList<BatchConverter::Job> jobs;
+    inputs.reserve(options.files);
+    outputs.reserve(options.files);
+    jobs.reserve(options.files);
+    for (int i = 0; i < options.files; ++i) {
+        const QString input = corpusPath(options.directory, "in", i);
+        const QString output = corpusPath(options.directory, "out", i);
+        inputs.push_back(QFile::encodeName(input).toStdString());
+        outputs.push_back(QFile::encodeName(output).toStdString());
+        jobs.append({input, output});
+    }
+
+    const ConverterLease lease = sharedConverter();
+    if (options.convert && !lease) {
+        std::fprintf(stderr, "zhoconv: %s\n", qPrintable(ConverterManager::instance().lastError()));
+        return 1;
+    }
+    const IConverterBackend *converter = lease.get();
+    const ZhoConfig config = options.config;
+    std::printf("%d files, %d bytes each, config %s%s (warm page cache)\n", options.files, options.fileSize,
+                configName(config), options.convert ? "" : ", I/O only");
+
+    uint64_t bytes = 0;
+#ifdef Q_OS_LINUX
+    const RunResult posix = runPosix(inputs, outputs, converter, config, options.convert);
+    printResult("posix, 1 thread", posix, options);
+    bytes = posix.bytes;
+    if (UringBatchIO::isSupported()) {
+        printResult("io_uring, 1 thread", runUring(inputs, outputs, converter, config, options.convert), options);
+    } else {
+        std::printf("%-24s not available\n", "io_uring, 1 thread");
+    }
+#else
+    std::printf("Raw syscall comparison needs Linux; running the batch converter only.\n");
+#endif
+
+    if (options.convert) {
+        printResult("batch, standard I/O", runBatchConverter(jobs, options.config, BatchConverter::StandardIo,
+                                                             bytes), options);
+        if (BatchConverter::isIoBackendAvailable(BatchConverter::UringIo)) {
+            printResult("batch, io_uring", runBatchConverter(jobs, options.config, BatchConverter::UringIo,
+                                                             bytes), options);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef IOBENCHMARK_H
+#define IOBENCHMARK_H
+
+#include <QString>
+#include "zhoconfig.h"
+
+struct IoBenchmarkOptions {
+    QString directory;
+    int files = 1000000;
+    int fileSize = 2048;
+    ZhoConfig config = ZhoConfig::S2t;
+    bool convert = true;
+};
+
+// Converts a corpus of many small files (generated under directory/in on
+// first use) with the per-file POSIX syscall loop and with the batched
+// io_uring backend, and prints throughput and syscalls per file for each,
+// followed by an end-to-end run of the batch converter with both backends.
+int runIoBenchmark(const IoBenchmarkOptions &options);
+
+#endif // IOBENCHMARK_H
@@ -0,0 +1,216 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "latencybenchmark.h"
+#include "batchconverter.h"
+#include "convertermanager.h"
+#include "taskscheduler.h"
+#include "cpuplacement.h"
+#include "resultstore.h"
+
+namespace {
+    const QByteArray sample_line = QByteArray(u8"简体中文转换为繁体中文，这是一个测试句子。\n");
+
+    double percentile(const std::vector<double> &sorted, const double fraction) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    void printLatencies(const char *name, std::vector<double> latencies) {
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("%-22s %5zu samples  p50 %7.2f  p95 %7.2f  p99 %7.2f  max %7.2f ms\n", name,
+                    latencies.size(), percentile(latencies, 0.50), percentile(latencies, 0.95),
+                    percentile(latencies, 0.99), latencies.empty() ? 0.0 : latencies.back());
+    }
+
+    bool generateCorpus(const LatencyBenchmarkOptions &options, QList<BatchConverter::Job> &jobs) {
+        const QString root = options.directory + "/latency";
+        QDir().mkpath(root + "/in");
+        QDir().mkpath(root + "/out");
+        QByteArray content;
+        for (int i = 0; i < options.files; ++i) {
+            const QString input = QStringLiteral("%1/in/%2.txt").arg(root).arg(i, 3, 10, QChar('0'));
+            jobs.append({input, QStringLiteral("%1/out/%2.txt").arg(root).arg(i, 3, 10, QChar('0'))});
+            if (QFileInfo(input).size() == options.fileSize) {
+                continue;
+            }
+            if (content.isEmpty()) {
+                std::printf("Generating %d files of %d bytes ...\n", options.files, options.fileSize);
+                while (content.size() + sample_line.size() <= options.fileSize) {
+                    content += sample_line;
+                }
+            }
+            QFile file(input);
+            if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size()) {
+                std::fprintf(stderr, "Cannot write %s\n", qPrintable(input));
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Samples snippet latency until the batch is done or enough samples are
+    // taken; with no jobs, just samples.
+    std::vector<double> sampleLatencies(const LatencyBenchmarkOptions &options, const std::string &snippet,
+                                        const QList<BatchConverter::Job> &jobs, double *batch_seconds) {
+        std::vector<double> latencies;
+        BatchConverter converter;
+        QElapsedTimer batch_timer;
+        batch_timer.start();
+        converter.start(jobs, options.config, false);
+
+        const ConverterLease lease = sharedConverter();
+        while (lease && static_cast<int>(latencies.size()) < options.samples &&
+               (jobs.isEmpty() || converter.isRunning())) {
+            QElapsedTimer timer;
+            timer.start();
+            TaskScheduler::instance().runInteractive([&] {
+                return zhoConvert(lease.get(), snippet.c_str(), options.config, false);
+            });
+            latencies.push_back(static_cast<double>(timer.nsecsElapsed()) / 1e6);
+
+            QThread::msleep(options.intervalMsec);
+            QCoreApplication::processEvents();
+        }
+        converter.waitForDone();
+        if (batch_seconds != nullptr) {
+            *batch_seconds = static_cast<double>(batch_timer.nsecsElapsed()) / 1e9;
+        }
+        return latencies;
+    }
+
+    // Loads the converter up front, so a load failure is reported rather
+    // than measured as a run without samples
+    bool loadConverter() {
+        if (sharedConverter()) {
+            return true;
+        }
+        std::fprintf(stderr, "zhoconv: %s\n", qPrintable(ConverterManager::instance().lastError()));
+        return false;
+    }
+
+    struct PlacementCase {
+        const char *name;
+        int threads;
+        CpuPlacement placement;
+    };
+}
+
+int runLatencyBenchmark(const LatencyBenchmarkOptions &options) {
+    if (options.files <= 0 || options.fileSize <= 0 || options.samples <= 0) {
+        std::fprintf(stderr, "Invalid benchmark options\n");
+        return 1;
+    }
+    if (!loadConverter()) {
+        return 1;
+    }
+    QList<BatchConverter::Job> jobs;
+    if (!generateCorpus(options, jobs)) {
+        return 1;
+    }
+
+    std::string snippet;
+    while (snippet.size() < 2048) {
+        snippet += sample_line.toStdString();
+    }
+    const double batch_mb = static_cast<double>(options.files) * options.fileSize / 1e6;
+    std::printf("Snippet %zu bytes every %d ms, batch %d x %d bytes, %d threads, config %s\n", snippet.size(),
+                options.intervalMsec, options.files, options.fileSize, TaskScheduler::instance().threadCount(),
+                configName(options.config));
+
+    TaskScheduler &scheduler = TaskScheduler::instance();
+    std::vector<double> latencies = sampleLatencies(options, snippet, {}, nullptr);
+    printLatencies("idle", latencies);
+    const QString workload = fileWorkload(options.files, options.fileSize);
+    appendResult("bench-latency", "idle", options.config, workload, 0, latencies);
+
+    double seconds = 0;
+    scheduler.setPreemption(false);
+    latencies = sampleLatencies(options, snippet, jobs, &seconds);
+    printLatencies("batch, no preemption", latencies);
+    std::printf("%-22s %9.1f MB/s\n", "  batch throughput", batch_mb / seconds);
+    appendResult("bench-latency", "batch, no preemption", options.config, workload, batch_mb / seconds,
+                 latencies);
+
+    scheduler.setPreemption(true);
+    latencies = sampleLatencies(options, snippet, jobs, &seconds);
+    printLatencies("batch, preemption", latencies);
+    std::printf("%-22s %9.1f MB/s\n", "  batch throughput", batch_mb / seconds);
+    appendResult("bench-latency", "batch, preemption", options.config, workload, batch_mb / seconds, latencies);
+
+    if (options.p99BudgetMsec > 0 && latencies.empty()) {
+        std::fprintf(stderr, "The batch finished before any snippet was converted\n");
+        return 1;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    if (const double p99 = percentile(latencies, 0.99); options.p99BudgetMsec > 0 && p99 > options.p99BudgetMsec) {
+        std::fprintf(stderr, "Snippet p99 %.2f ms under batch load is over the %.2f ms budget\n", p99,
+                     options.p99BudgetMsec);
+        return 1;
+    }
+    return 0;
+}
+
+int runPlacementBenchmark(const LatencyBenchmarkOptions &options) {
+    if (options.files <= 0 || options.fileSize <= 0 || options.samples <= 0) {
+        std::fprintf(stderr, "Invalid benchmark options\n");
+        return 1;
+    }
+    if (!loadConverter()) {
+        return 1;
+    }
+    QList<BatchConverter::Job> jobs;
+    if (!generateCorpus(options, jobs)) {
+        return 1;
+    }
+    std::string snippet;
+    while (snippet.size() < 2048) {
+        snippet += sample_line.toStdString();
+    }
+
+    const CpuTopology &topology = cpuTopology();
+    std::printf("Performance cores: %s\nEfficiency cores:  %s\n",
+                qPrintable(formatCpuList(topology.performance)),
+                topology.efficiency.isEmpty() ? "none" : qPrintable(formatCpuList(topology.efficiency)));
+
+    const int all = static_cast<int>(topology.all().size());
+    QList<PlacementCase> cases{
+        {"all CPUs", all, {}},
+        {"half the threads", std::max(1, all / 2), {}},
+    };
+    if (topology.isHybrid()) {
+        cases.append({"performance cores", static_cast<int>(topology.performance.size()), {topology.performance}});
+        cases.append({"efficiency cores", static_cast<int>(topology.efficiency.size()), {topology.efficiency}});
+        cases.append({"prefer performance", all, {{}, 0, true}});
+    }
+    // Last: an unprivileged process cannot lower nice again
+    cases.append({"nice 10", all, {{}, 10, false}});
+
+    const double batch_mb = static_cast<double>(options.files) * options.fileSize / 1e6;
+    TaskScheduler &scheduler = TaskScheduler::instance();
+    scheduler.setPreemption(true);
+    for (const PlacementCase &run: cases) {
+        scheduler.setThreadCount(run.threads);
+        scheduler.setPlacement(run.placement);
+        double seconds = 0;
+        std::vector<double> latencies = sampleLatencies(options, snippet, jobs, &seconds);
+        std::sort(latencies.begin(), latencies.end());
+        std::printf("%-20s %3d threads  %9.1f MB/s  snippet p99 %7.2f ms\n", run.name, run.threads,
+                    batch_mb / seconds, percentile(latencies, 0.99));
+        appendResult("bench-cpu", run.name, options.config, fileWorkload(options.files, options.fileSize),
+                     batch_mb / seconds, latencies);
+    }
+    scheduler.setThreadCount(0);
+    scheduler.setPlacement({});
+    return 0;
+}
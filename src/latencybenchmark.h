@@ -0,0 +1,33 @@
+#ifndef LATENCYBENCHMARK_H
+#define LATENCYBENCHMARK_H
+
+#include <QString>
+#include "zhoconfig.h"
+
+struct LatencyBenchmarkOptions {
+    QString directory;
+    int files = 32;
+    int fileSize = 8 * 1024 * 1024;
+    int samples = 500;
+    int intervalMsec = 10;
+    ZhoConfig config = ZhoConfig::S2t;
+    // Snippet p99 allowed under batch load with preemption; 0: no limit
+    double p99BudgetMsec = 0;
+};
+
+// Measures the latency of converting a short snippet as interactive work
+// while the batch converter works through a corpus of large files
+// (generated under directory/latency on first use). Prints p50 / p95 / p99 /
+// max for an idle system, for batch load without preemption, and for batch
+// load with the TaskScheduler preempting batch chunks, plus the batch
+// throughput of both loaded runs. Returns 1 when the preempted p99 is over
+// p99BudgetMsec, so it can run as a test.
+int runLatencyBenchmark(const LatencyBenchmarkOptions &options);
+
+// Runs the same loaded measurement (with preemption) under several thread
+// counts and CPU placements: every CPU, half the threads, performance cores
+// only, efficiency cores only, heavy work on performance cores, and nice 10.
+// Prints the detected topology, then throughput and snippet p99 per row.
+int runPlacementBenchmark(const LatencyBenchmarkOptions &options);
+
+#endif // LATENCYBENCHMARK_H
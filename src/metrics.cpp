@@ -0,0 +1,170 @@
+#include <QMetaEnum>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "metrics.h"
+#include "batchconverter.h"
+#include "convertermanager.h"
+#include "taskscheduler.h"
+
+namespace {
+    // Upper bounds of the file latency histogram, in seconds; a last
+    // bucket takes the rest (+Inf).
+    constexpr double latency_bounds[] = {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 60};
+    constexpr int bucket_count = std::size(latency_bounds) + 1;
+    constexpr int status_count = BatchConverter::ConvertError + 1;
+
+    const char *const counter_names[] = {
+        "zho_input_bytes_total", "zho_output_bytes_total", "zho_chars_total", "zho_converter_cache_hits_total",
+        "zho_converter_cache_misses_total"
+    };
+    const char *const counter_help[] = {
+        "UTF-8 bytes converted.", "UTF-8 bytes produced.", "Characters produced.",
+        "Conversions that found the converter loaded.", "Conversions that had to load the converter."
+    };
+    const char *const priority_names[] = {"interactive", "speculative", "batch", "background"};
+
+    using Cell = std::atomic<quint64>;
+
+    struct Slab {
+        Cell counters[Metrics::counter_count] = {};
+        Cell files[status_count] = {};
+        Cell buckets[zho_config_count][bucket_count] = {};
+        Cell latencyNsecs[zho_config_count] = {};
+        std::atomic<bool> inUse{true};
+    };
+
+    std::mutex registry_mutex;
+    std::vector<std::unique_ptr<Slab>> registry;
+
+    // Hands the slab back when its thread ends
+    struct SlabOwner {
+        Slab *slab = nullptr;
+
+        ~SlabOwner() {
+            if (slab != nullptr) {
+                slab->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    Slab &threadSlab() {
+        thread_local SlabOwner owner;
+        if (owner.slab == nullptr) {
+            std::lock_guard lock(registry_mutex);
+            for (const auto &slab: registry) {
+                bool free = false;
+                if (slab->inUse.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                    owner.slab = slab.get();
+                    break;
+                }
+            }
+            if (owner.slab == nullptr) {
+                registry.push_back(std::make_unique<Slab>());
+                owner.slab = registry.back().get();
+            }
+        }
+        return *owner.slab;
+    }
+
+    // Only the owning thread writes a cell, so no read-modify-write needed
+    void bump(Cell &cell, const quint64 value) {
+        cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // Sums one cell over all slabs
+    template<typename Select>
+    quint64 total(Select select) {
+        quint64 sum = 0;
+        for (const auto &slab: registry) {
+            sum += select(*slab).load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    void header(QByteArray &out, const char *name, const char *type, const char *help) {
+        out += QByteArray("# HELP ") + name + ' ' + help + "\n# TYPE " + name + ' ' + type + '\n';
+    }
+}
+
+void Metrics::add(const Counter counter, const quint64 value) {
+    bump(threadSlab().counters[counter], value);
+}
+
+void Metrics::addFile(const int status) {
+    if (status >= 0 && status < status_count) {
+        bump(threadSlab().files[status], 1);
+    }
+}
+
+void Metrics::observeFile(const ZhoConfig config, const qint64 nsecs) {
+    const double seconds = static_cast<double>(nsecs) / 1e9;
+    int bucket = 0;
+    while (bucket < bucket_count - 1 && seconds > latency_bounds[bucket]) {
+        ++bucket;
+    }
+    Slab &slab = threadSlab();
+    const auto index = static_cast<size_t>(config);
+    bump(slab.buckets[index][bucket], 1);
+    bump(slab.latencyNsecs[index], static_cast<quint64>(std::max<qint64>(0, nsecs)));
+}
+
+void Metrics::addConversion(const size_t input_bytes, const char *output, const size_t output_bytes) {
+    size_t chars = 0;
+    for (size_t i = 0; i < output_bytes; ++i) {
+        chars += (static_cast<unsigned char>(output[i]) & 0xC0) != 0x80;
+    }
+    Slab &slab = threadSlab();
+    bump(slab.counters[InputBytes], input_bytes);
+    bump(slab.counters[OutputBytes], output_bytes);
+    bump(slab.counters[Chars], chars);
+}
+
+QByteArray Metrics::render() {
+    QByteArray out;
+    std::lock_guard lock(registry_mutex);
+
+    for (int counter = 0; counter < counter_count; ++counter) {
+        header(out, counter_names[counter], "counter", counter_help[counter]);
+        out += QByteArray(counter_names[counter]) + ' ' +
+                QByteArray::number(total([counter](Slab &slab) -> Cell & { return slab.counters[counter]; })) + '\n';
+    }
+
+    header(out, "zho_files_total", "counter", "Batch files finished, by status.");
+    const QMetaEnum statuses = QMetaEnum::fromType<BatchConverter::Status>();
+    for (int status = 0; status < status_count; ++status) {
+        out += QByteArray("zho_files_total{status=\"") + statuses.valueToKey(status) + "\"} " +
+                QByteArray::number(total([status](Slab &slab) -> Cell & { return slab.files[status]; })) + '\n';
+    }
+
+    header(out, "zho_file_seconds", "histogram", "Time to convert one batch file, by config.");
+    for (size_t config = 0; config < zho_config_count; ++config) {
+        const QByteArray label = QByteArray("config=\"") + configName(static_cast<ZhoConfig>(config)) + '"';
+        quint64 cumulative = 0;
+        for (int bucket = 0; bucket < bucket_count; ++bucket) {
+            cumulative += total([config, bucket](Slab &slab) -> Cell & { return slab.buckets[config][bucket]; });
+            const QByteArray bound = bucket < bucket_count - 1
+                                         ? QByteArray::number(latency_bounds[bucket])
+                                         : QByteArray("+Inf");
+            out += "zho_file_seconds_bucket{" + label + ",le=\"" + bound + "\"} " + QByteArray::number(cumulative) +
+                    '\n';
+        }
+        const quint64 nsecs = total([config](Slab &slab) -> Cell & { return slab.latencyNsecs[config]; });
+        out += "zho_file_seconds_sum{" + label + "} " + QByteArray::number(static_cast<double>(nsecs) / 1e9) + '\n';
+        out += "zho_file_seconds_count{" + label + "} " + QByteArray::number(cumulative) + '\n';
+    }
+
+    header(out, "zho_queue_depth", "gauge", "Tasks waiting in the scheduler, by priority class.");
+    for (int priority = TaskScheduler::Interactive; priority <= TaskScheduler::Background; ++priority) {
+        out += QByteArray("zho_queue_depth{priority=\"") + priority_names[priority] + "\"} " +
+                QByteArray::number(TaskScheduler::instance().queuedCount(
+                    static_cast<TaskScheduler::Priority>(priority))) + '\n';
+    }
+
+    header(out, "zho_resident_bytes", "gauge", "Resident memory of the process.");
+    out += "zho_resident_bytes " + QByteArray::number(ConverterManager::residentBytes()) + '\n';
+    return out;
+}
@@ -0,0 +1,42 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include "zhoconfig.h"
+
+// Process-wide conversion counters for monitoring unattended runs, rendered
+// in the Prometheus text format (see MetricsServer). Every thread counts
+// into its own slab of relaxed atomics, which only that thread writes, so
+// recording is a load and a store with no shared cache lines; render()
+// sums the slabs. Slabs of finished threads are handed to new threads, so
+// totals never go backwards.
+class Metrics {
+public:
+    enum Counter {
+        InputBytes,
+        OutputBytes,
+        Chars,
+        CacheHits,
+        CacheMisses,
+        counter_count
+    };
+
+    static void add(Counter counter, quint64 value = 1);
+
+    // Counts a finished batch file by BatchConverter::Status.
+    static void addFile(int status);
+
+    // Per-config histogram of the time to convert one file.
+    static void observeFile(ZhoConfig config, qint64 nsecs);
+
+    // Converted input and output, with output characters counted from its
+    // UTF-8 lead bytes.
+    static void addConversion(size_t input_bytes, const char *output, size_t output_bytes);
+
+    // Counters, histograms and the gauges sampled now: scheduler queue
+    // depths and resident memory.
+    static QByteArray render();
+};
+
+#endif // METRICS_H
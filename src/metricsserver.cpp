@@ -0,0 +1,72 @@
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include "metricsserver.h"
+#include "metrics.h"
+
+namespace {
+    // A scrape request is a few hundred bytes; drop clients that send more
+    // without finishing their headers.
+    constexpr qint64 max_request_bytes = 8192;
+    // Clients that do not finish their headers in time are dropped too, so
+    // idle connections cannot pile up.
+    constexpr int header_timeout_msec = 10000;
+}
+
+MetricsServer::MetricsServer(QObject *parent) : QObject(parent), server(new QTcpServer(this)) {
+    connect(server, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+bool MetricsServer::listen(const quint16 port) {
+    close();
+    return server->listen(QHostAddress::LocalHost, port);
+}
+
+void MetricsServer::close() {
+    server->close();
+}
+
+bool MetricsServer::isListening() const {
+    return server->isListening();
+}
+
+quint16 MetricsServer::port() const {
+    return server->serverPort();
+}
+
+void MetricsServer::onNewConnection() {
+    while (QTcpSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        auto *timeout = new QTimer(socket);
+        timeout->setSingleShot(true);
+        connect(timeout, &QTimer::timeout, socket, &QTcpSocket::abort);
+        timeout->start(header_timeout_msec);
+        connect(socket, &QTcpSocket::readyRead, socket, [socket, timeout] {
+            const QByteArray request = socket->peek(max_request_bytes);
+            if (!request.contains("\r\n\r\n")) {
+                if (request.size() >= max_request_bytes) {
+                    socket->abort();
+                }
+                return;
+            }
+            timeout->stop();
+            socket->readAll();
+            const QList<QByteArray> request_line = request.left(request.indexOf("\r\n")).split(' ');
+            QByteArray body;
+            QByteArray status = "200 OK";
+            QByteArray type = "text/plain; version=0.0.4; charset=utf-8";
+            if (request_line.size() < 2 || request_line.at(0) != "GET" ||
+                (request_line.at(1) != "/metrics" && !request_line.at(1).startsWith("/metrics?"))) {
+                status = "404 Not Found";
+                type = "text/plain";
+                body = "Not found\n";
+            } else {
+                body = Metrics::render();
+            }
+            socket->write("HTTP/1.1 " + status + "\r\nContent-Type: " + type + "\r\nContent-Length: " +
+                          QByteArray::number(body.size()) + "\r\nConnection: close\r\n\r\n" + body);
+            socket->disconnectFromHost();
+        });
+    }
+}
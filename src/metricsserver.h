@@ -0,0 +1,32 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+
+class QTcpServer;
+
+// Serves Metrics::render() as `GET /metrics` on localhost, for Prometheus
+// to scrape while batches or a watched folder run unattended. One request
+// per connection; anything else gets 404. Connections that send no complete
+// request headers within 10 s are closed.
+class MetricsServer : public QObject {
+Q_OBJECT
+
+public:
+    explicit MetricsServer(QObject *parent = nullptr);
+
+    bool listen(quint16 port);
+
+    void close();
+
+    bool isListening() const;
+
+    quint16 port() const;
+
+private:
+    void onNewConnection();
+
+    QTcpServer *server;
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,194 @@
+#include <QAbstractEventDispatcher>
+#include <QCoreApplication>
+#include <QEvent>
+#include <QMetaEnum>
+#include <algorithm>
+#include <chrono>
+#include "responsivenessmonitor.h"
+
+namespace {
+    constexpr int recent_stalls = 50;
+    // Watchdog samples per threshold of a long-running iteration
+    constexpr int samples_per_threshold = 4;
+    // An iteration running this many thresholds, and at least
+    // hang_floor_msec, is reported before it ends
+    constexpr int hang_thresholds = 10;
+    constexpr qint64 hang_floor_msec = 2000;
+}
+
+ResponsivenessMonitor::Activity::Activity(const char *name)
+    : previous(instance().activity.exchange(name)) {
+}
+
+ResponsivenessMonitor::Activity::~Activity() {
+    instance().activity.store(previous);
+}
+
+ResponsivenessMonitor &ResponsivenessMonitor::instance() {
+    static ResponsivenessMonitor monitor;
+    return monitor;
+}
+
+ResponsivenessMonitor::~ResponsivenessMonitor() {
+    stop();
+}
+
+void ResponsivenessMonitor::start(const int threshold_msec) {
+    stop();
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance();
+    if (dispatcher == nullptr || threshold_msec <= 0) {
+        return;
+    }
+    {
+        std::lock_guard lock(mutex);
+        threshold = threshold_msec;
+        stopping = false;
+        sampledBeat = -1;
+        samples.clear();
+        hangReportedBeat = -1;
+        counts = QList<qint64>(bucket_count, 0);
+        stalls.clear();
+        longest = 0;
+    }
+    clock.start();
+    beatNsecs = 0;
+    blocked = true;
+    connections << connect(dispatcher, &QAbstractEventDispatcher::awake, this, [this] { heartbeat(false); },
+                           Qt::DirectConnection);
+    connections << connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, [this] { heartbeat(true); },
+                           Qt::DirectConnection);
+    QCoreApplication::instance()->installEventFilter(this);
+    watchdog = std::thread([this] { watch(); });
+}
+
+void ResponsivenessMonitor::stop() {
+    for (const QMetaObject::Connection &connection: connections) {
+        disconnect(connection);
+    }
+    connections.clear();
+    if (QCoreApplication *application = QCoreApplication::instance()) {
+        application->removeEventFilter(this);
+    }
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (watchdog.joinable()) {
+        watchdog.join();
+    }
+}
+
+int ResponsivenessMonitor::thresholdMsec() const {
+    return threshold;
+}
+
+QList<qint64> ResponsivenessMonitor::bucketBounds() const {
+    QList<qint64> bounds;
+    for (qint64 bound = threshold; bounds.size() < bucket_count; bound *= 2) {
+        bounds.append(bound);
+    }
+    return bounds;
+}
+
+QList<qint64> ResponsivenessMonitor::histogram() const {
+    std::lock_guard lock(mutex);
+    return counts;
+}
+
+QList<ResponsivenessMonitor::Stall> ResponsivenessMonitor::recentStalls() const {
+    std::lock_guard lock(mutex);
+    return stalls;
+}
+
+qint64 ResponsivenessMonitor::longestStallMsec() const {
+    std::lock_guard lock(mutex);
+    return longest;
+}
+
+bool ResponsivenessMonitor::eventFilter(QObject *watched, QEvent *event) {
+    eventClass.store(watched->metaObject()->className(), std::memory_order_relaxed);
+    eventType.store(event->type(), std::memory_order_relaxed);
+    return false;
+}
+
+// GUI thread, from the dispatcher: ends the running iteration, which is a
+// stall if it ran past the threshold (time spent blocked does not count).
+void ResponsivenessMonitor::heartbeat(const bool blocking) {
+    const qint64 now = clock.nsecsElapsed();
+    const qint64 beat = beatNsecs.exchange(now);
+    if (blocked.exchange(blocking)) {
+        return;
+    }
+    const qint64 msec = (now - beat) / 1000000;
+    if (msec < threshold) {
+        return;
+    }
+
+    QString what;
+    {
+        std::lock_guard lock(mutex);
+        if (sampledBeat == beat && !samples.isEmpty()) {
+            what = std::max_element(samples.cbegin(), samples.cend()).key();
+        }
+    }
+    if (what.isEmpty()) {
+        what = describeCurrent();
+    }
+    int bucket = 0;
+    for (qint64 bound = 2LL * threshold; bucket < bucket_count - 1 && msec >= bound; bound *= 2) {
+        ++bucket;
+    }
+    {
+        std::lock_guard lock(mutex);
+        ++counts[bucket];
+        stalls.append({QDateTime::currentDateTime(), msec, what});
+        if (stalls.size() > recent_stalls) {
+            stalls.removeFirst();
+        }
+        longest = std::max(longest, msec);
+    }
+    qWarning("Event loop stalled %lld ms in %s", msec, qPrintable(what));
+}
+
+void ResponsivenessMonitor::watch() {
+    std::unique_lock lock(mutex);
+    const auto interval = std::chrono::milliseconds(std::max(1, threshold / samples_per_threshold));
+    const qint64 hang_msec = std::max<qint64>(hang_floor_msec, static_cast<qint64>(threshold) * hang_thresholds);
+    while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+        const qint64 beat = beatNsecs;
+        if (blocked) {
+            continue;
+        }
+        // Only iterations on their way to a stall are sampled
+        const qint64 busy_msec = (clock.nsecsElapsed() - beat) / 1000000;
+        if (busy_msec < threshold / 2) {
+            continue;
+        }
+        if (sampledBeat != beat) {
+            sampledBeat = beat;
+            samples.clear();
+        }
+        const QString what = describeCurrent();
+        ++samples[what];
+        if (busy_msec >= hang_msec && hangReportedBeat != beat) {
+            hangReportedBeat = beat;
+            qWarning("Event loop not responding for %lld ms, in %s", busy_msec, qPrintable(what));
+        }
+    }
+}
+
+QString ResponsivenessMonitor::describeCurrent() const {
+    if (const char *name = activity.load()) {
+        return QString::fromUtf8(name);
+    }
+    const char *class_name = eventClass.load(std::memory_order_relaxed);
+    if (class_name == nullptr) {
+        return QStringLiteral("event loop");
+    }
+    const int type = eventType.load(std::memory_order_relaxed);
+    const char *type_name = QMetaEnum::fromType<QEvent::Type>().valueToKey(type);
+    return QStringLiteral("%1 event to %2")
+            .arg(type_name != nullptr ? QString::fromLatin1(type_name) : QString::number(type),
+                 QString::fromLatin1(class_name));
+}
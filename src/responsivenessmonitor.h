@@ -0,0 +1,113 @@
+#ifndef RESPONSIVENESSMONITOR_H
+#define RESPONSIVENESSMONITOR_H
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Watches the GUI thread's event loop for stalls. The event dispatcher's
+// awake() and aboutToBlock() signals are its heartbeats: a loop iteration
+// that runs longer than the threshold before blocking or starting the next
+// one is a stall, during which no input is handled and nothing repaints.
+//
+// A watchdog thread samples what the GUI thread is doing while an
+// iteration runs long: the innermost Activity, or else the class and type
+// of the last event delivered (from an application event filter). The
+// activity seen most often is recorded with the stall, logged, and counted
+// in a histogram for the diagnostics view. Iterations that never end are
+// reported by the watchdog while they last.
+//
+// Per heartbeat and per event the GUI thread only stores atomics.
+class ResponsivenessMonitor : public QObject {
+public:
+    // Names the work the GUI thread runs for its lifetime, for stall
+    // reports; nests. GUI thread only; name must be static (a literal or
+    // Q_FUNC_INFO).
+    class Activity {
+    public:
+        explicit Activity(const char *name);
+
+        ~Activity();
+
+        Activity(const Activity &) = delete;
+
+        Activity &operator=(const Activity &) = delete;
+
+    private:
+        const char *previous;
+    };
+
+    struct Stall {
+        QDateTime time;
+        qint64 msec = 0;
+        QString activity;
+    };
+
+    // Stall histogram buckets double from the threshold: [t, 2t), [2t, 4t),
+    // ..., and the last is open-ended
+    static constexpr int bucket_count = 7;
+
+    static ResponsivenessMonitor &instance();
+
+    // Starts watching the calling thread's event loop, recording stalls of
+    // at least threshold_msec; restarting resets the statistics.
+    void start(int threshold_msec);
+
+    void stop();
+
+    int thresholdMsec() const;
+
+    // Lower bound of each bucket, in ms
+    QList<qint64> bucketBounds() const;
+
+    QList<qint64> histogram() const;
+
+    // The last stalls, oldest first.
+    QList<Stall> recentStalls() const;
+
+    qint64 longestStallMsec() const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    ResponsivenessMonitor() = default;
+
+    ~ResponsivenessMonitor() override;
+
+    void heartbeat(bool blocking);
+
+    void watch();
+
+    QString describeCurrent() const;
+
+    std::atomic<int> threshold{0};
+    QElapsedTimer clock;
+    // Time of the last heartbeat, and whether the loop has blocked since
+    std::atomic<qint64> beatNsecs{0};
+    std::atomic<bool> blocked{true};
+    std::atomic<const char *> activity{nullptr};
+    std::atomic<const char *> eventClass{nullptr};
+    std::atomic<int> eventType{0};
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::thread watchdog;
+    bool stopping = false;
+    // Watchdog samples of the iteration that began at sampledBeat
+    qint64 sampledBeat = -1;
+    QHash<QString, int> samples;
+    qint64 hangReportedBeat = -1;
+    QList<qint64> counts;
+    QList<Stall> stalls;
+    qint64 longest = 0;
+    QList<QMetaObject::Connection> connections;
+};
+
+#endif // RESPONSIVENESSMONITOR_H
@@ -0,0 +1,237 @@
+#include <QMap>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include "resultreport.h"
+#include "resultstore.h"
+
+namespace {
+    constexpr int chart_width = 40;
+    // Earlier runs a run is compared with, and how many it needs
+    constexpr int history_runs = 10;
+    constexpr int min_history = 5;
+    constexpr double noise_multiple = 3;
+    // Below 1% a change is not worth flagging, however steady the series
+    constexpr double noise_floor = 0.01;
+    constexpr size_t min_samples = 8;
+
+    double percentile(const std::vector<double> &sorted, const double fraction) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    double median(std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        return percentile(values, 0.5);
+    }
+
+    // Median absolute deviation scaled to a standard deviation, robust to
+    // the odd disturbed run
+    double robustDeviation(const std::vector<double> &values) {
+        const double middle = median(values);
+        std::vector<double> deviations;
+        deviations.reserve(values.size());
+        for (const double value: values) {
+            deviations.push_back(std::abs(value - middle));
+        }
+        return 1.4826 * median(deviations);
+    }
+
+    // True when value lies beyond the noise of the previous values
+    bool isShift(const std::vector<double> &previous, const double value) {
+        if (previous.size() < static_cast<size_t>(min_history) || value <= 0) {
+            return false;
+        }
+        const double middle = median(previous);
+        const double noise = std::max(robustDeviation(previous), noise_floor * middle);
+        return std::abs(value - middle) > noise_multiple * noise;
+    }
+
+    // Two-sided Mann-Whitney U test with tie correction, by the normal
+    // approximation (both samples are at least min_samples). Returns p.
+    // Takes the stored stride of each run, not its peaks, so the samples
+    // stay representative.
+    double mannWhitney(const std::vector<double> &a, const std::vector<double> &b) {
+        std::vector<std::pair<double, int>> all;
+        all.reserve(a.size() + b.size());
+        for (const double value: a) {
+            all.emplace_back(value, 0);
+        }
+        for (const double value: b) {
+            all.emplace_back(value, 1);
+        }
+        std::sort(all.begin(), all.end());
+        const double n1 = static_cast<double>(a.size());
+        const double n2 = static_cast<double>(b.size());
+        const double n = n1 + n2;
+        double rank_sum = 0;
+        double ties = 0;
+        for (size_t i = 0; i < all.size();) {
+            size_t j = i;
+            while (j < all.size() && all[j].first == all[i].first) {
+                ++j;
+            }
+            const double rank = (static_cast<double>(i + j) + 1) / 2;
+            const double count = static_cast<double>(j - i);
+            for (size_t k = i; k < j; ++k) {
+                rank_sum += all[k].second == 0 ? rank : 0;
+            }
+            ties += count * count * count - count;
+            i = j;
+        }
+        const double u = rank_sum - n1 * (n1 + 1) / 2;
+        const double variance = n1 * n2 / 12 * (n + 1 - ties / (n * (n - 1)));
+        if (variance <= 0) {
+            return 1;
+        }
+        const double z = (u - n1 * n2 / 2) / std::sqrt(variance);
+        return std::erfc(std::abs(z) / std::sqrt(2.0));
+    }
+
+    void printRun(const StoredResult &result, const double max_throughput, const bool throughput_shift,
+                  const bool latency_shift) {
+        const int bar = max_throughput > 0
+                            ? static_cast<int>(std::lround(result.mbPerSecond / max_throughput * chart_width))
+                            : 0;
+        QString marks;
+        if (throughput_shift) {
+            marks += " *MB/s";
+        }
+        if (latency_shift) {
+            marks += " *p99";
+        }
+        std::printf("%6d  %s  %-12s %9.1f %-*s", result.id,
+                    qPrintable(result.time.toString("yyyy-MM-dd hh:mm")), qPrintable(result.commit.left(12)),
+                    result.mbPerSecond, chart_width, qPrintable(QString(bar, '#')));
+        if (result.latencyCount == 0) {
+            std::printf(" %8s %8s %8s", "-", "-", "-");
+        } else {
+            // p50 and p99 of all the samples, as recorded before thinning
+            std::printf(" %8.2f %8.2f %8.2f", result.p50Msec, result.p99Msec,
+                        result.peakLatencies.empty() ? result.p99Msec : result.peakLatencies.front());
+        }
+        std::printf("  %s%s\n", qPrintable(result.converter), qPrintable(marks));
+    }
+
+    int printSeries(const QList<StoredResult> &results, const QString &kind) {
+        QMap<QString, QList<StoredResult>> series;
+        for (const StoredResult &result: results) {
+            if (kind.isEmpty() || result.kind == kind) {
+                series[result.series()].append(result);
+            }
+        }
+        if (series.isEmpty()) {
+            std::printf("No results%s\n", kind.isEmpty() ? "" : qPrintable(" of kind " + kind));
+            return 0;
+        }
+        int shifts = 0;
+        qsizetype run_count = 0;
+        for (auto it = series.cbegin(); it != series.cend(); ++it) {
+            const QList<StoredResult> &runs = it.value();
+            run_count += runs.size();
+            double max_throughput = 0;
+            for (const StoredResult &run: runs) {
+                max_throughput = std::max(max_throughput, run.mbPerSecond);
+            }
+            std::printf("\n%s\n%6s  %-16s  %-12s %9s %-*s %8s %8s %8s  %s\n", qPrintable(it.key()), "id", "time",
+                        "commit", "MB/s", chart_width, "", "p50 ms", "p99 ms", "max ms", "converter");
+            std::vector<double> throughputs;
+            std::vector<double> p99s;
+            for (const StoredResult &run: runs) {
+                const std::vector<double> previous_throughputs(
+                    throughputs.end() - std::min<std::ptrdiff_t>(throughputs.size(), history_runs), throughputs.end());
+                const std::vector<double> previous_p99s(
+                    p99s.end() - std::min<std::ptrdiff_t>(p99s.size(), history_runs), p99s.end());
+                const double p99 = run.p99Msec;
+                const bool throughput_shift = isShift(previous_throughputs, run.mbPerSecond);
+                const bool latency_shift = isShift(previous_p99s, p99);
+                shifts += throughput_shift || latency_shift;
+                printRun(run, max_throughput, throughput_shift, latency_shift);
+                if (run.mbPerSecond > 0) {
+                    throughputs.push_back(run.mbPerSecond);
+                }
+                if (run.latencyCount > 0) {
+                    p99s.push_back(p99);
+                }
+            }
+        }
+        std::printf("\n%d series, %lld runs, %d marked (* beyond %.0fx the noise of the previous %d runs)\n",
+                    static_cast<int>(series.size()), static_cast<long long>(run_count), shifts, noise_multiple,
+                    history_runs);
+        return 0;
+    }
+
+    int compareRuns(const QList<StoredResult> &results, const ResultReportOptions &options) {
+        const StoredResult *first = nullptr;
+        const StoredResult *second = nullptr;
+        for (const StoredResult &result: results) {
+            first = result.id == options.first ? &result : first;
+            second = result.id == options.second ? &result : second;
+        }
+        if (first == nullptr || second == nullptr) {
+            std::fprintf(stderr, "zhoconv: no result %d in %s\n", first == nullptr ? options.first : options.second,
+                         qPrintable(options.path));
+            return 2;
+        }
+        for (const StoredResult *run: {first, second}) {
+            std::printf("%6d  %s\n        %s, commit %s, %s, %d threads\n", run->id, qPrintable(run->series()),
+                        qPrintable(run->time.toString(Qt::ISODate)), qPrintable(run->commit),
+                        qPrintable(run->converter), run->threads);
+        }
+        if (first->series() != second->series()) {
+            std::printf("Note: the runs are of different series\n");
+        }
+
+        bool significant = false;
+        if (first->mbPerSecond > 0 && second->mbPerSecond > 0) {
+            std::vector<double> steps;
+            const StoredResult *previous = nullptr;
+            for (const StoredResult &result: results) {
+                if (result.series() != first->series() || result.mbPerSecond <= 0) {
+                    continue;
+                }
+                if (previous != nullptr) {
+                    steps.push_back(result.mbPerSecond - previous->mbPerSecond);
+                }
+                previous = &result;
+            }
+            const double change = second->mbPerSecond - first->mbPerSecond;
+            std::printf("Throughput: %.1f -> %.1f MB/s (%+.1f%%)", first->mbPerSecond, second->mbPerSecond,
+                        100 * change / first->mbPerSecond);
+            if (steps.size() + 1 < static_cast<size_t>(min_history)) {
+                std::printf(", not tested: fewer than %d runs in the series\n", min_history);
+            } else {
+                const double noise = std::max(robustDeviation(steps), noise_floor * first->mbPerSecond);
+                const bool shift = std::abs(change) > noise_multiple * noise;
+                significant |= shift;
+                std::printf(", run-to-run noise %.1f MB/s: %s\n", noise, shift ? "significant" : "within noise");
+            }
+        }
+        if (first->latencyCount > 0 && second->latencyCount > 0) {
+            std::printf("Latency: p50 %.2f -> %.2f ms, p99 %.2f -> %.2f ms", first->p50Msec, second->p50Msec,
+                        first->p99Msec, second->p99Msec);
+            if (first->latencies.size() < min_samples || second->latencies.size() < min_samples) {
+                std::printf(", not tested: fewer than %zu samples\n", min_samples);
+            } else {
+                const double p = mannWhitney(first->latencies, second->latencies);
+                const bool shift = p < options.alpha;
+                significant |= shift;
+                std::printf(", Mann-Whitney p = %.3g: %s\n", p, shift ? "significant" : "not significant");
+            }
+        }
+        return significant ? 1 : 0;
+    }
+}
+
+int runResultReport(const ResultReportOptions &options) {
+    const QList<StoredResult> results = loadResults(options.path);
+    std::printf("Results store %s\n", qPrintable(options.path));
+    if (options.first != 0 || options.second != 0) {
+        return compareRuns(results, options);
+    }
+    return printSeries(results, options.kind);
+}
@@ -0,0 +1,28 @@
+#ifndef RESULTREPORT_H
+#define RESULTREPORT_H
+
+#include <QString>
+
+struct ResultReportOptions {
+    QString path;     // the results store
+    QString kind;     // only results of this kind; empty: all
+    int first = 0;    // --compare ids (store line numbers); 0: none
+    int second = 0;
+    double alpha = 0.01;
+};
+
+// Prints the store per series (one kind, row, config, host, thread count
+// and workload), oldest run first: throughput as a bar chart over time and
+// latency p50 / p99 / max, with the commit and converter of each run. A run
+// whose throughput or p99 lies beyond the noise of the runs before it is
+// marked.
+//
+// With two ids, compares those runs instead: latency with a Mann-Whitney U
+// test on their stored (evenly thinned) samples, throughput against the
+// run-to-run noise of the first run's series (a single figure per run has
+// no spread of its own).
+// Returns a process exit code: 0, or 1 when the comparison finds a
+// significant change.
+int runResultReport(const ResultReportOptions &options);
+
+#endif // RESULTREPORT_H
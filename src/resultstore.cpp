@@ -0,0 +1,203 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+#include <QSysInfo>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <utility>
+#include "resultstore.h"
+#include "convertermanager.h"
+#include "taskscheduler.h"
+#include "zhocommit.h"
+
+namespace {
+    // Largest samples stored apart from the stride
+    constexpr size_t peak_samples = max_stored_samples / 50;
+
+    // Keeps every step-th sample, so the stored ones still span the run
+    std::vector<double> thinned(const std::vector<double> &samples) {
+        if (samples.size() <= static_cast<size_t>(max_stored_samples)) {
+            return samples;
+        }
+        std::vector<double> kept;
+        kept.reserve(max_stored_samples);
+        const double step = static_cast<double>(samples.size()) / max_stored_samples;
+        for (int i = 0; i < max_stored_samples; ++i) {
+            kept.push_back(samples[static_cast<size_t>(i * step)]);
+        }
+        return kept;
+    }
+
+    double percentile(const std::vector<double> &sorted, const double fraction) {
+        if (sorted.empty()) {
+            return 0;
+        }
+        const auto rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+        return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+    }
+
+    // Sets the count, percentiles and peaks from result.latencies
+    void summarizeLatencies(StoredResult &result) {
+        std::vector<double> sorted = result.latencies;
+        std::sort(sorted.begin(), sorted.end());
+        result.latencyCount = static_cast<qint64>(sorted.size());
+        result.p50Msec = percentile(sorted, 0.50);
+        result.p99Msec = percentile(sorted, 0.99);
+        result.peakLatencies.assign(sorted.rbegin(), sorted.rbegin() +
+                                    static_cast<std::ptrdiff_t>(std::min(peak_samples, sorted.size())));
+    }
+
+    // Does not load the converter just for this; an evicted one is named
+    // without its version
+    QString converterIdentity() {
+        ConverterManager &manager = ConverterManager::instance();
+        const ConverterLease converter = manager.isLoaded() ? manager.acquire() : nullptr;
+        if (!converter) {
+            return manager.backendName();
+        }
+        const QString version = converter->version();
+        return version.isEmpty() ? converter->name() : converter->name() + ' ' + version;
+    }
+}
+
+QString StoredResult::series() const {
+    QString key = QStringLiteral("%1 | %2 | %3 | %4 | %5 threads").arg(kind, name, configName(config), host)
+            .arg(threads);
+    if (!workload.isEmpty()) {
+        key += " | " + workload;
+    }
+    return key;
+}
+
+QString fileWorkload(const qint64 files, const qint64 file_bytes) {
+    return QStringLiteral("%1 x %2 B").arg(files).arg(file_bytes);
+}
+
+QString batchWorkload(const qint64 files, const qint64 total_bytes) {
+    const auto ceil_pow2 = [](const qint64 value) {
+        qint64 bound = 1;
+        while (bound < value) {
+            bound *= 2;
+        }
+        return bound;
+    };
+    return QStringLiteral("<= %1 files, <= %2 MiB").arg(ceil_pow2(files))
+            .arg(ceil_pow2((total_bytes + (1 << 20) - 1) >> 20));
+}
+
+QString resultStorePath() {
+    if (const QString path = qEnvironmentVariable("ZHO_RESULTS"); !path.isEmpty()) {
+        return path;
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/laisuk/results.jsonl";
+}
+
+bool appendResult(StoredResult result) {
+    result.time = QDateTime::currentDateTime();
+    result.commit = qEnvironmentVariable("ZHO_COMMIT", QStringLiteral(ZHO_GIT_COMMIT));
+    result.converter = converterIdentity();
+    result.host = QStringLiteral("%1-%2").arg(QSysInfo::machineHostName()).arg(QThread::idealThreadCount());
+    result.threads = TaskScheduler::instance().threadCount();
+    summarizeLatencies(result);
+
+    QJsonArray latencies;
+    for (const double latency: thinned(result.latencies)) {
+        latencies.append(latency);
+    }
+    QJsonArray peaks;
+    for (const double latency: result.peakLatencies) {
+        peaks.append(latency);
+    }
+    const QJsonObject record{
+        {"time", result.time.toString(Qt::ISODateWithMs)},
+        {"kind", result.kind},
+        {"name", result.name},
+        {"config", configName(result.config)},
+        {"workload", result.workload},
+        {"mb_per_s", result.mbPerSecond},
+        {"latencies_ms", latencies},
+        {"latency_count", result.latencyCount},
+        {"p50_ms", result.p50Msec},
+        {"p99_ms", result.p99Msec},
+        {"peak_latencies_ms", peaks},
+        {"commit", result.commit},
+        {"converter", result.converter},
+        {"host", result.host},
+        {"threads", result.threads}
+    };
+
+    const QString path = resultStorePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    // One write per line, so concurrent appends from the GUI and zhoconv
+    // do not interleave
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append) ||
+        !file.write(QJsonDocument(record).toJson(QJsonDocument::Compact) + '\n')) {
+        std::fprintf(stderr, "Cannot append to results store %s\n", qPrintable(path));
+        return false;
+    }
+    return true;
+}
+
+bool appendResult(const QString &kind, const QString &name, const ZhoConfig config, const QString &workload,
+                  const double mb_per_second, const std::vector<double> &latencies) {
+    StoredResult result;
+    result.kind = kind;
+    result.name = name;
+    result.config = config;
+    result.workload = workload;
+    result.mbPerSecond = mb_per_second;
+    result.latencies = latencies;
+    return appendResult(std::move(result));
+}
+
+QList<StoredResult> loadResults(const QString &path) {
+    QList<StoredResult> results;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return results;
+    }
+    int line_number = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        ++line_number;
+        const QJsonObject record = QJsonDocument::fromJson(line).object();
+        StoredResult result;
+        // Lines from other versions or cut short by a crash are skipped
+        if (record.isEmpty() || !parseConfig(record.value("config").toString().toStdString(), result.config)) {
+            continue;
+        }
+        result.id = line_number;
+        result.time = QDateTime::fromString(record.value("time").toString(), Qt::ISODateWithMs);
+        result.kind = record.value("kind").toString();
+        result.name = record.value("name").toString();
+        result.workload = record.value("workload").toString();
+        result.mbPerSecond = record.value("mb_per_s").toDouble();
+        for (const QJsonValue latency: record.value("latencies_ms").toArray()) {
+            result.latencies.push_back(latency.toDouble());
+        }
+        if (record.contains("latency_count")) {
+            result.latencyCount = record.value("latency_count").toInteger();
+            result.p50Msec = record.value("p50_ms").toDouble();
+            result.p99Msec = record.value("p99_ms").toDouble();
+            for (const QJsonValue latency: record.value("peak_latencies_ms").toArray()) {
+                result.peakLatencies.push_back(latency.toDouble());
+            }
+        } else {
+            // Older records keep only the samples
+            summarizeLatencies(result);
+        }
+        result.commit = record.value("commit").toString();
+        result.converter = record.value("converter").toString();
+        result.host = record.value("host").toString();
+        result.threads = record.value("threads").toInt();
+        results.append(result);
+    }
+    return results;
+}
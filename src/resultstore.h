@@ -0,0 +1,71 @@
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <vector>
+#include "zhoconfig.h"
+
+// Batch runs (GUI and zhoconv) and the zhoconv --bench-* modes append
+// their results to a local store, so zhoconv --report can follow them
+// across commits, library updates and hosts.
+
+// One row of a benchmark or one batch run, as kept in the results store.
+struct StoredResult {
+    QString kind;           // "batch", "bench-latency", "bench-backends", ...
+    QString name;           // the row within a run, e.g. "batch, preemption"
+    ZhoConfig config = ZhoConfig::S2t;
+    QString workload;       // input shape, from fileWorkload() or batchWorkload()
+    double mbPerSecond = 0; // 0: not measured
+    // Latency samples in ms; stored as an even stride of at most
+    // max_stored_samples, so they stay a fair sample of the run
+    std::vector<double> latencies;
+
+    // Set by appendResult()
+    // Of all the latency samples, before thinning: their number, p50 and
+    // p99, and the largest (the rare stalls a stride skips), largest first
+    qint64 latencyCount = 0;
+    double p50Msec = 0;
+    double p99Msec = 0;
+    std::vector<double> peakLatencies;
+    QDateTime time;
+    QString commit;    // build commit, or $ZHO_COMMIT
+    QString converter; // backend name and version
+    QString host;      // host name and thread count
+    int threads = 0;   // TaskScheduler threads
+
+    // Line number in the store, set by loadResults()
+    int id = 0;
+
+    // Results of the same measurement of the same workload on the same host
+    // and thread count, comparable over time
+    QString series() const;
+};
+
+inline constexpr int max_stored_samples = 1000;
+
+// Workload of a run over files inputs of file_bytes each
+QString fileWorkload(qint64 files, qint64 file_bytes);
+
+// Workload of a batch of files totalling total_bytes; both are rounded up
+// to a power of two, so batches of about the same shape share a series
+QString batchWorkload(qint64 files, qint64 total_bytes);
+
+// The JSON Lines file results are appended to: $ZHO_RESULTS if set, else
+// results.jsonl in the shared "laisuk" data directory, so the GUI and
+// zhoconv write one store.
+QString resultStorePath();
+
+// Stamps result with the time, build commit, converter, host and thread
+// count and appends it to the store. Returns false if the store cannot be
+// written (benchmarks still print their results).
+bool appendResult(StoredResult result);
+
+bool appendResult(const QString &kind, const QString &name, ZhoConfig config, const QString &workload,
+                  double mb_per_second, const std::vector<double> &latencies = {});
+
+// Every readable result in the store at path, oldest first.
+QList<StoredResult> loadResults(const QString &path);
+
+#endif // RESULTSTORE_H
@@ -0,0 +1,254 @@
+#include <QElapsedTimer>
+#include <QFile>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "roundtripchecker.h"
+#include "compressedio.h"
+#include "convertermanager.h"
+#include "taskscheduler.h"
+#include "zhoutilities.h"
+
+namespace {
+    constexpr size_t block_size = 4 * 1024 * 1024;
+
+    struct Span {
+        quint64 count = 0;
+        QStringList examples;
+    };
+
+    // Keyed by source, converted and round-tripped span, tab-separated
+    using SpanMap = std::unordered_map<std::string, Span>;
+
+    struct Totals {
+        std::mutex mutex;
+        std::condition_variable done;
+        int inFlight = 0;
+        SpanMap spans;
+        quint64 chars = 0;
+        quint64 lines = 0;
+        quint64 changedLines = 0;
+        bool failed = false;
+    };
+
+    std::vector<std::string_view> splitLines(const std::string_view text) {
+        std::vector<std::string_view> lines;
+        size_t start = 0;
+        while (start <= text.size()) {
+            const size_t end = std::min(text.find('\n', start), text.size());
+            lines.push_back(text.substr(start, end - start));
+            start = end + 1;
+        }
+        return lines;
+    }
+
+    QString fromUcs4(const QList<uint> &chars, const qsizetype begin, const qsizetype end) {
+        return QString::fromUcs4(reinterpret_cast<const char32_t *>(chars.constData()) + begin, end - begin);
+    }
+
+    void addSpan(SpanMap &spans, const QList<uint> &source, const QList<uint> &converted,
+                 const QList<uint> &round_trip, const qsizetype begin, const qsizetype end, const qsizetype back_end,
+                 const RoundTripOptions &options) {
+        // The converted span is known only where conversion kept the length
+        const QString forward = converted.size() == source.size() ? fromUcs4(converted, begin, end) : QString("?");
+        const std::string key = (fromUcs4(source, begin, end) + '\t' + forward + '\t' +
+                                 fromUcs4(round_trip, begin, back_end)).toStdString();
+        Span &span = spans[key];
+        ++span.count;
+        if (span.examples.size() < options.examples) {
+            const qsizetype from = std::max<qsizetype>(0, begin - options.contextChars);
+            const qsizetype to = std::min(source.size(), end + options.contextChars);
+            QString example = fromUcs4(source, from, begin) + '[' + fromUcs4(source, begin, end) + ']' +
+                              fromUcs4(source, end, to);
+            span.examples.append(example.replace('\t', ' ').replace('\r', ' '));
+        }
+    }
+
+    // Compares one line with its round trip. Lines of equal length are
+    // compared character by character, so each changed run is its own
+    // span; otherwise the line minus the common prefix and suffix is one.
+    void compareLine(SpanMap &spans, const std::string_view source_line, const std::string_view converted_line,
+                     const std::string_view back_line, const RoundTripOptions &options) {
+        const QList<uint> source = QString::fromUtf8(source_line.data(), source_line.size()).toUcs4();
+        const QList<uint> converted = QString::fromUtf8(converted_line.data(), converted_line.size()).toUcs4();
+        const QList<uint> round_trip = QString::fromUtf8(back_line.data(), back_line.size()).toUcs4();
+        if (source.size() == round_trip.size()) {
+            qsizetype i = 0;
+            while (i < source.size()) {
+                if (source[i] == round_trip[i]) {
+                    ++i;
+                    continue;
+                }
+                const qsizetype begin = i;
+                while (i < source.size() && source[i] != round_trip[i]) {
+                    ++i;
+                }
+                addSpan(spans, source, converted, round_trip, begin, i, i, options);
+            }
+            return;
+        }
+        qsizetype prefix = 0;
+        while (prefix < source.size() && prefix < round_trip.size() && source[prefix] == round_trip[prefix]) {
+            ++prefix;
+        }
+        qsizetype suffix = 0;
+        while (suffix < source.size() - prefix && suffix < round_trip.size() - prefix &&
+               source[source.size() - 1 - suffix] == round_trip[round_trip.size() - 1 - suffix]) {
+            ++suffix;
+        }
+        addSpan(spans, source, converted, round_trip, prefix, source.size() - suffix, round_trip.size() - suffix,
+                options);
+    }
+
+    void checkBlock(const IConverterBackend *converter, const std::string &block, const RoundTripOptions &options,
+                    Totals &totals) {
+        const std::string converted = zhoConvert(converter, block.c_str(), options.config, options.punctuation);
+        const std::string back = zhoConvert(converter, converted.c_str(), inverseConfig(options.config),
+                                            options.punctuation);
+        SpanMap spans;
+        quint64 changed_lines = 0;
+        const auto source_lines = splitLines(block);
+        const auto converted_lines = splitLines(converted);
+        const auto back_lines = splitLines(back);
+        if (source_lines.size() == back_lines.size() && source_lines.size() == converted_lines.size()) {
+            for (size_t i = 0; i < source_lines.size(); ++i) {
+                if (source_lines[i] != back_lines[i]) {
+                    ++changed_lines;
+                    compareLine(spans, source_lines[i], converted_lines[i], back_lines[i], options);
+                }
+            }
+        } else if (block != back) {
+            ++changed_lines;
+            compareLine(spans, block, converted, back, options);
+        }
+
+        quint64 chars = 0;
+        for (const char c: block) {
+            chars += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+        }
+        std::lock_guard lock(totals.mutex);
+        for (auto &[key, span]: spans) {
+            Span &total = totals.spans[key];
+            total.count += span.count;
+            for (const QString &example: span.examples) {
+                if (total.examples.size() < options.examples) {
+                    total.examples.append(example);
+                }
+            }
+        }
+        totals.chars += chars;
+        totals.lines += source_lines.size();
+        totals.changedLines += changed_lines;
+    }
+
+    // Reads source in blocks cut at safe boundaries and queues each for
+    // checking, waiting while too many are in flight.
+    bool submitBlocks(ByteSource &source, const IConverterBackend *converter, const RoundTripOptions &options,
+                      Totals &totals, TaskScheduler::Group &group, quint64 &bytes) {
+        const int max_in_flight = 2 * TaskScheduler::instance().threadCount();
+        std::string pending;
+        std::vector<char> buffer(block_size);
+        bool at_end = false;
+        while (!at_end || !pending.empty()) {
+            if (!at_end && pending.size() < block_size) {
+                const size_t count = source.read(buffer.data(), buffer.size());
+                pending.append(buffer.data(), count);
+                bytes += count;
+                at_end = count == 0;
+                continue;
+            }
+            const size_t boundary = at_end ? pending.size() : find_split_boundary(pending, block_size);
+            if (boundary == 0) {
+                return false;
+            }
+            auto block = std::make_shared<std::string>(pending, 0, boundary);
+            pending.erase(0, boundary);
+            {
+                std::unique_lock lock(totals.mutex);
+                totals.done.wait(lock, [&] { return totals.inFlight < max_in_flight; });
+                ++totals.inFlight;
+            }
+            TaskScheduler::instance().submit(TaskScheduler::Batch, [converter, block, &options, &totals] {
+                checkBlock(converter, *block, options, totals);
+                std::lock_guard lock(totals.mutex);
+                --totals.inFlight;
+                totals.done.notify_all();
+            }, &group);
+        }
+        return !source.failed();
+    }
+}
+
+int runRoundTripCheck(const RoundTripOptions &options) {
+    const ConverterLease converter = sharedConverter();
+    if (!converter) {
+        std::fprintf(stderr, "zhoconv: %s\n", qPrintable(ConverterManager::instance().lastError()));
+        return 1;
+    }
+    QFile report(options.report);
+    if (!report.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::fprintf(stderr, "zhoconv: cannot write report %s\n", qPrintable(options.report));
+        return 3;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    Totals totals;
+    TaskScheduler::Group group;
+    quint64 bytes = 0;
+    const QStringList files = options.files.isEmpty() ? QStringList{QString()} : options.files;
+    for (const QString &path: files) {
+        FILE *file = path.isEmpty() ? stdin : std::fopen(QFile::encodeName(path).constData(), "rb");
+        if (file == nullptr) {
+            std::fprintf(stderr, "zhoconv: cannot open input %s\n", qPrintable(path));
+            totals.failed = true;
+            continue;
+        }
+        const auto source = makeSource(file);
+        if (!submitBlocks(*source, converter.get(), options, totals, group, bytes)) {
+            std::fprintf(stderr, "zhoconv: cannot read %s: %s\n", path.isEmpty() ? "standard input" : qPrintable(path),
+                         source->failed() ? source->errorString().c_str() : "not UTF-8 text");
+            totals.failed = true;
+        }
+        // Queued blocks are copies, so the file can close
+        if (file != stdin) {
+            std::fclose(file);
+        }
+    }
+    group.wait();
+    const double seconds = static_cast<double>(timer.nsecsElapsed()) / 1e9;
+
+    std::vector<std::pair<std::string, Span>> spans(std::make_move_iterator(totals.spans.begin()),
+                                                    std::make_move_iterator(totals.spans.end()));
+    std::sort(spans.begin(), spans.end(), [](const auto &a, const auto &b) {
+        return a.second.count != b.second.count ? a.second.count > b.second.count : a.first < b.first;
+    });
+    quint64 span_count = 0;
+    for (const auto &[key, span]: spans) {
+        span_count += span.count;
+    }
+
+    const QString summary = QStringLiteral("%1 -> %2: %3 MB, %4 characters, %5 of %6 lines changed, %7 spans in %8 "
+                                           "forms, %9 s (%10 MB/s)")
+            .arg(configName(options.config), configName(inverseConfig(options.config)))
+            .arg(static_cast<double>(bytes) / 1e6, 0, 'f', 1).arg(totals.chars).arg(totals.changedLines)
+            .arg(totals.lines).arg(span_count).arg(spans.size()).arg(seconds, 0, 'f', 2)
+            .arg(static_cast<double>(bytes) / 1e6 / std::max(seconds, 1e-9), 0, 'f', 1);
+    report.write("# Round trip " + summary.toUtf8() + '\n');
+    report.write("count\tsource\tconverted\tround trip\texamples\n");
+    for (const auto &[key, span]: spans) {
+        report.write(QByteArray::number(span.count) + '\t' + QByteArray::fromStdString(key) + '\t' +
+                     span.examples.join(" | ").toUtf8() + '\n');
+    }
+    if (!report.flush()) {
+        std::fprintf(stderr, "zhoconv: cannot write report %s\n", qPrintable(options.report));
+        return 3;
+    }
+    std::printf("%s\n", qPrintable(summary));
+    return totals.failed ? 2 : 0;
+}
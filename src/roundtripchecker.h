@@ -0,0 +1,29 @@
+#ifndef ROUNDTRIPCHECKER_H
+#define ROUNDTRIPCHECKER_H
+
+#include <QString>
+#include <QStringList>
+#include "zhoconfig.h"
+
+struct RoundTripOptions {
+    QStringList files; // empty: standard input
+    QString report;
+    ZhoConfig config = ZhoConfig::S2t;
+    bool punctuation = false;
+    int contextChars = 12;
+    int examples = 3;
+};
+
+// Finds one-to-many mappings by converting a corpus with config and back
+// with inverseConfig(config) (s2t then t2s, tw2s then s2tw ...) and
+// collecting every span that comes back different. Input is read as
+// blocks (gzip / zstd decoded) that the TaskScheduler checks in parallel
+// as batch work, with a bounded number in flight, so memory stays flat on
+// any corpus size.
+//
+// The report is a tab-separated file, most frequent first: count, source
+// span, converted span, round-tripped span and a few examples with the
+// span in [brackets] in its context. Returns a process exit code.
+int runRoundTripCheck(const RoundTripOptions &options);
+
+#endif // ROUNDTRIPCHECKER_H
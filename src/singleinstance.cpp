@@ -0,0 +1,74 @@
+#include <QDataStream>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include "singleinstance.h"
+
+SingleInstance::SingleInstance(const QString &key, QObject *parent) : QObject(parent) {
+    // Local socket names live in a shared namespace on Unix (/tmp); keep
+    // users from handing files to each other's windows.
+    QString user = qEnvironmentVariable("USER");
+    if (user.isEmpty()) {
+        user = qEnvironmentVariable("USERNAME");
+    }
+    serverName = key + "-" + user;
+}
+
+bool SingleInstance::sendToRunning(const QStringList &arguments, const int timeout_msec) const {
+    QLocalSocket socket;
+    socket.connectToServer(serverName);
+    if (!socket.waitForConnected(timeout_msec)) {
+        return false;
+    }
+    QByteArray message;
+    QDataStream out(&message, QIODevice::WriteOnly);
+    out << arguments;
+    socket.write(message);
+    if (!socket.waitForBytesWritten(timeout_msec) || !socket.waitForReadyRead(timeout_msec)) {
+        return false;
+    }
+    socket.disconnectFromServer();
+    return true;
+}
+
+SingleInstance::ListenResult SingleInstance::listen(const int timeout_msec) {
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, &QLocalServer::newConnection, this, &SingleInstance::onNewConnection);
+    if (server->listen(serverName)) {
+        return Listening;
+    }
+    if (server->serverError() != QAbstractSocket::AddressInUseError) {
+        return NotListening;
+    }
+    // sendToRunning() also fails when the running instance is only slow to
+    // answer; the socket is left over from a crash only if nobody is there
+    QLocalSocket probe;
+    probe.connectToServer(serverName);
+    if (probe.waitForConnected(timeout_msec)) {
+        probe.disconnectFromServer();
+        return RunningElsewhere;
+    }
+    if (probe.error() != QLocalSocket::ConnectionRefusedError && probe.error() != QLocalSocket::ServerNotFoundError) {
+        return RunningElsewhere;
+    }
+    QLocalServer::removeServer(serverName);
+    return server->listen(serverName) ? Listening : NotListening;
+}
+
+void SingleInstance::onNewConnection() {
+    while (QLocalSocket *socket = server->nextPendingConnection()) {
+        connect(socket, &QLocalSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket] {
+            QDataStream in(socket);
+            in.startTransaction();
+            QStringList arguments;
+            in >> arguments;
+            if (!in.commitTransaction()) {
+                return;
+            }
+            socket->write("1", 1);
+            socket->flush();
+            emit argumentsReceived(arguments);
+        });
+    }
+}
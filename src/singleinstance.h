@@ -0,0 +1,47 @@
+#ifndef SINGLEINSTANCE_H
+#define SINGLEINSTANCE_H
+
+#include <QObject>
+#include <QStringList>
+
+class QLocalServer;
+
+// Keeps one running ZhoConverterQt per user. A second launch hands its file
+// arguments to the first over a QLocalSocket and exits, so the files open in
+// a window whose Qt and converter start-up are already paid for.
+//
+// Messages are a QDataStream-serialised QStringList; the receiver answers
+// with one byte once it has taken them. An empty list just raises the
+// running window.
+class SingleInstance : public QObject {
+Q_OBJECT
+
+public:
+    enum ListenResult {
+        Listening,
+        NotListening,
+        // Another instance holds the name but did not take the hand-off in time
+        RunningElsewhere
+    };
+
+    explicit SingleInstance(const QString &key, QObject *parent = nullptr);
+
+    // Returns true if a running instance accepted the arguments.
+    bool sendToRunning(const QStringList &arguments, int timeout_msec = 1000) const;
+
+    // Starts accepting hand-offs. Call once sendToRunning() has failed. A
+    // socket nobody listens on is left over from a crash and replaced; one
+    // that a connect does not fail on at once belongs to a live instance.
+    ListenResult listen(int timeout_msec = 1000);
+
+signals:
+    void argumentsReceived(const QStringList &arguments);
+
+private:
+    void onNewConnection();
+
+    QString serverName;
+    QLocalServer *server = nullptr;
+};
+
+#endif // SINGLEINSTANCE_H
@@ -0,0 +1,49 @@
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QPair>
+#include "startupprofiler.h"
+
+namespace {
+    struct StartupLog {
+        QMutex mutex;
+        QElapsedTimer timer;
+        QList<QPair<QString, double>> marks;
+        QList<QPair<QString, double>> deferred;
+    };
+
+    StartupLog &startupLog() {
+        static StartupLog log;
+        return log;
+    }
+}
+
+void startupMark(const char *milestone) {
+    StartupLog &log = startupLog();
+    QMutexLocker locker(&log.mutex);
+    if (!log.timer.isValid()) {
+        log.timer.start();
+    }
+    log.marks.append({QString::fromUtf8(milestone), static_cast<double>(log.timer.nsecsElapsed()) / 1e6});
+}
+
+void startupDeferred(const char *work, const double msec) {
+    StartupLog &log = startupLog();
+    QMutexLocker locker(&log.mutex);
+    log.deferred.append({QString::fromUtf8(work), msec});
+}
+
+QString startupReport() {
+    StartupLog &log = startupLog();
+    QMutexLocker locker(&log.mutex);
+    QString report;
+    for (const auto &mark: log.marks) {
+        report += QStringLiteral("%1 %2 ms\n").arg(mark.first, -20).arg(mark.second, 9, 'f', 1);
+    }
+    for (const auto &work: log.deferred) {
+        report += QStringLiteral("%1 %2 ms (deferred, not in the above)\n")
+                .arg("+ " + work.first, -20)
+                .arg(work.second, 9, 'f', 1);
+    }
+    return report;
+}
@@ -0,0 +1,19 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QString>
+
+// Start-up milestones, timed from the first startupMark() call (made at the
+// top of main()). Thread-safe; the converter warm-up marks from a pool
+// thread. Used by `ZhoConverterQt --startup-benchmark`.
+void startupMark(const char *milestone);
+
+// Records work moved off the start-up path, with the time it took when it
+// did run, so the report shows what start-up no longer pays for.
+void startupDeferred(const char *work, double msec);
+
+// One "milestone  time ms" line per mark, in the order recorded, then one
+// line per deferred piece of work that has run.
+QString startupReport();
+
+#endif // STARTUPPROFILER_H
@@ -0,0 +1,57 @@
+#include "streamconverter.h"
+#include "metrics.h"
+#include "zhoutilities.h"
+
+StreamConverter::StreamConverter(const IConverterBackend *converter, const ZhoConfig config, const bool punctuation,
+                                 const size_t block_size)
+    : handle(converter), zhoConfig(config), isPunctuation(punctuation), normalize(textNormalization(config)),
+      maxBlock(block_size) {
+    pending.reserve(maxBlock * 2);
+}
+
+void StreamConverter::push(const std::string_view data, std::string &out) {
+    if (conversionFailed) {
+        return;
+    }
+    pending.append(data);
+    if (pending.size() < maxBlock) {
+        return;
+    }
+
+    size_t offset = 0;
+    while (pending.size() - offset >= maxBlock && !conversionFailed) {
+        const std::string_view rest(pending.data() + offset, pending.size() - offset);
+        // A run of stray continuation bytes has no boundary; cut it anyway,
+        // or pending would grow until finish()
+        size_t boundary = find_split_boundary(rest, maxBlock);
+        if (boundary == 0) {
+            boundary = maxBlock;
+        }
+        convert(rest.substr(0, boundary), out);
+        offset += boundary;
+    }
+    pending.erase(0, offset);
+}
+
+void StreamConverter::finish(std::string &out) {
+    if ((!pending.empty() || !normalizeState.held.empty()) && !conversionFailed) {
+        convert(pending, out, true);
+        pending.clear();
+    }
+}
+
+void StreamConverter::convert(const std::string_view segment, std::string &out, const bool last) {
+    // convert() takes a NUL-terminated string; normalize while
+    // making that copy
+    std::string input;
+    appendNormalized(segment, normalize, input, &normalizeState);
+    if (last) {
+        finishNormalized(normalizeState, input);
+    }
+    const size_t start = out.size();
+    if (!handle->convert(input.c_str(), zhoConfig, isPunctuation, out)) {
+        conversionFailed = true;
+        return;
+    }
+    Metrics::addConversion(segment.size(), out.data() + start, out.size() - start);
+}
@@ -0,0 +1,50 @@
+#ifndef STREAMCONVERTER_H
+#define STREAMCONVERTER_H
+
+#include <string>
+#include <string_view>
+#include "converterbackend.h"
+#include "textnormalizer.h"
+#include "zhoconfig.h"
+
+// Incremental conversion of a UTF-8 stream. Input is buffered until at least
+// one block is available, then converted up to a phrase-safe boundary (see
+// find_split_boundary); the remainder is carried over to the next block.
+// Memory stays bounded by roughly two blocks regardless of stream length.
+// Blocks are normalized (see textNormalization()) as they are copied for
+// conversion.
+class StreamConverter {
+public:
+    static constexpr size_t default_block_size = 1 << 20;
+
+    StreamConverter(const IConverterBackend *converter, ZhoConfig config, bool punctuation,
+                    size_t block_size = default_block_size);
+
+    // Appends data and converts every complete block. Converted text is
+    // appended to out.
+    void push(std::string_view data, std::string &out);
+
+    // Converts whatever is still buffered. Call once at end of stream.
+    void finish(std::string &out);
+
+    // Whether the converter failed on a block. Nothing more is converted
+    // after a failure.
+    bool failed() const { return conversionFailed; }
+
+    size_t blockSize() const { return maxBlock; }
+
+private:
+    // last: the end of the text, where normalization holds nothing back
+    void convert(std::string_view segment, std::string &out, bool last = false);
+
+    const IConverterBackend *handle;
+    ZhoConfig zhoConfig;
+    bool isPunctuation;
+    NormalizeOptions normalize;
+    NormalizeState normalizeState;
+    bool conversionFailed = false;
+    size_t maxBlock;
+    std::string pending;
+};
+
+#endif // STREAMCONVERTER_H
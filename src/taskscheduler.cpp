@@ -0,0 +1,178 @@
+#include <QThread>
+#include <utility>
+#include "taskscheduler.h"
+
+namespace {
+    // Priority class of the task running on this thread, -1 outside tasks
+    thread_local int current_priority = -1;
+
+    // Placement this pool thread last applied; generation 0 is the default
+    // (no pinning, no nice) that threads start with.
+    thread_local int applied_generation = 0;
+    thread_local bool applied_heavy = false;
+}
+
+void TaskScheduler::Group::wait() {
+    std::unique_lock lock(mutex);
+    done.wait(lock, [this] { return outstanding == 0; });
+}
+
+TaskScheduler &TaskScheduler::instance() {
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+TaskScheduler::TaskScheduler() {
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+void TaskScheduler::submit(const Priority priority, std::function<void()> task, Group *group) {
+    {
+        std::lock_guard lock(mutex);
+        ++queued[priority];
+    }
+    if (group != nullptr) {
+        std::lock_guard lock(group->mutex);
+        ++group->outstanding;
+    }
+    // QThreadPool runs higher numbers first
+    pool.start([this, priority, task = std::move(task), group] {
+        {
+            std::lock_guard lock(mutex);
+            --queued[priority];
+        }
+        changed.notify_all();
+
+        applyPlacement(priority);
+        current_priority = priority;
+        yieldPoint();
+        task();
+        current_priority = -1;
+
+        if (group != nullptr) {
+            std::lock_guard lock(group->mutex);
+            if (--group->outstanding == 0) {
+                group->done.notify_all();
+            }
+        }
+    }, Background - priority);
+}
+
+void TaskScheduler::yieldPoint() {
+    if (current_priority < 0) {
+        return;
+    }
+    instance().pause(current_priority);
+}
+
+void TaskScheduler::pause(const int priority) {
+    std::unique_lock lock(mutex);
+    if (!preempt || !demandAbove(priority)) {
+        return;
+    }
+    // Hand the thread over only as often as there is queued work to take
+    // it; foreground work runs on its own thread and needs none.
+    const bool release = queuedAbove(priority) > released;
+    if (release) {
+        ++released;
+        lock.unlock();
+        pool.releaseThread();
+        lock.lock();
+    }
+    changed.wait(lock, [this, priority] { return !preempt || !demandAbove(priority); });
+    if (release) {
+        --released;
+        lock.unlock();
+        pool.reserveThread();
+    }
+}
+
+int TaskScheduler::queuedAbove(const int priority) const {
+    int count = 0;
+    for (int p = Interactive; p < priority; ++p) {
+        count += queued[p];
+    }
+    return count;
+}
+
+bool TaskScheduler::demandAbove(const int priority) const {
+    return (priority > Interactive && foreground > 0) || queuedAbove(priority) > 0;
+}
+
+void TaskScheduler::setPreemption(const bool enabled) {
+    {
+        std::lock_guard lock(mutex);
+        preempt = enabled;
+    }
+    changed.notify_all();
+}
+
+bool TaskScheduler::preemption() const {
+    std::lock_guard lock(mutex);
+    return preempt;
+}
+
+void TaskScheduler::setThreadCount(const int count) {
+    pool.setMaxThreadCount(count > 0 ? count : QThread::idealThreadCount());
+}
+
+int TaskScheduler::threadCount() const {
+    return pool.maxThreadCount();
+}
+
+int TaskScheduler::queuedCount(const Priority priority) const {
+    std::lock_guard lock(mutex);
+    return queued[priority];
+}
+
+void TaskScheduler::setPlacement(const CpuPlacement &placement) {
+    std::lock_guard lock(mutex);
+    cpuPlacement = placement;
+    ++placementGeneration;
+}
+
+CpuPlacement TaskScheduler::placement() const {
+    std::lock_guard lock(mutex);
+    return cpuPlacement;
+}
+
+void TaskScheduler::applyPlacement(const int priority) {
+    CpuPlacement wanted;
+    int generation;
+    {
+        std::lock_guard lock(mutex);
+        wanted = cpuPlacement;
+        generation = placementGeneration;
+    }
+    // Heavy classes keep the performance cores; speculative warm-up and
+    // background work make do with the efficiency cores.
+    const bool heavy = priority == Interactive || priority == Batch;
+    if (generation == applied_generation && (heavy == applied_heavy || !wanted.preferPerformanceCores)) {
+        return;
+    }
+
+    setThreadAffinity(placementCpus(wanted, heavy));
+    if (generation != applied_generation && !setThreadNice(wanted.nice)) {
+        std::lock_guard lock(mutex);
+        if (niceFailedGeneration != generation) {
+            niceFailedGeneration = generation;
+            qWarning("Cannot set conversion threads to nice %d (lowest allowed: %d)", wanted.nice,
+                     lowestThreadNice(wanted.nice));
+        }
+    }
+    applied_generation = generation;
+    applied_heavy = heavy;
+}
+
+TaskScheduler::ForegroundScope::ForegroundScope(TaskScheduler &scheduler) : owner(scheduler) {
+    std::lock_guard lock(owner.mutex);
+    ++owner.foreground;
+}
+
+TaskScheduler::ForegroundScope::~ForegroundScope() {
+    {
+        std::lock_guard lock(owner.mutex);
+        --owner.foreground;
+    }
+    owner.changed.notify_all();
+}
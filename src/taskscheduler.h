@@ -0,0 +1,102 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <QThreadPool>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include "cpuplacement.h"
+
+// The process-wide thread pool, shared by all conversion work and ordered
+// by priority class. Queued tasks start highest class first. Long tasks call
+// yieldPoint() between chunks; while work of a higher class is waiting
+// there, the task pauses and, if that work is queued, hands its thread over,
+// so a snippet converted during a large batch waits at most one batch chunk.
+class TaskScheduler {
+public:
+    enum Priority {
+        Interactive,
+        Speculative,
+        Batch,
+        Background
+    };
+
+    // Tracks the tasks of one owner so it can wait for just those.
+    class Group {
+    public:
+        void wait();
+
+    private:
+        friend class TaskScheduler;
+        std::mutex mutex;
+        std::condition_variable done;
+        int outstanding = 0;
+    };
+
+    static TaskScheduler &instance();
+
+    void submit(Priority priority, std::function<void()> task, Group *group = nullptr);
+
+    // Runs task on the calling thread (e.g. the GUI thread) as interactive
+    // work: pooled tasks of every other class pause at their next
+    // yieldPoint() until it returns.
+    template<typename Task>
+    auto runInteractive(Task &&task) {
+        const ForegroundScope scope(*this);
+        return task();
+    }
+
+    // Pause point for the running pool task. Returns at once outside pool
+    // tasks, when preemption is off, or when nothing more urgent waits.
+    static void yieldPoint();
+
+    // Off: yieldPoint() never pauses (for comparison in benchmarks).
+    void setPreemption(bool enabled);
+
+    bool preemption() const;
+
+    void setThreadCount(int count);
+
+    int threadCount() const;
+
+    // Tasks of this class waiting for a thread.
+    int queuedCount(Priority priority) const;
+
+    // Applied lazily by each pool thread before its next task; a nice level
+    // a thread cannot take (see lowestThreadNice()) is logged once.
+    void setPlacement(const CpuPlacement &placement);
+
+    CpuPlacement placement() const;
+
+private:
+    TaskScheduler();
+
+    struct ForegroundScope {
+        explicit ForegroundScope(TaskScheduler &scheduler);
+
+        ~ForegroundScope();
+
+        TaskScheduler &owner;
+    };
+
+    void pause(int priority);
+
+    int queuedAbove(int priority) const;
+
+    bool demandAbove(int priority) const;
+
+    void applyPlacement(int priority);
+
+    QThreadPool pool;
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    int queued[Background + 1] = {};
+    int foreground = 0;
+    int released = 0;
+    bool preempt = true;
+    CpuPlacement cpuPlacement;
+    int placementGeneration = 0;
+    int niceFailedGeneration = 0;
+};
+
+#endif // TASKSCHEDULER_H
@@ -0,0 +1,459 @@
+#include <QDir>
+#include <QFile>
+#include <QString>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include "textnormalizer.h"
+
+namespace {
+    std::mutex options_mutex;
+    NormalizeOptions current_options;
+    QString variant_directory;
+    std::shared_ptr<const VariantTable> variant_tables[zho_config_count];
+
+    // Variants whose standard form is the same in simplified and
+    // traditional text
+    constexpr char32_t shared_variants[][2] = {
+        {U'氷', U'冰'}, {U'兎', U'兔'}, {U'吿', U'告'}, {U'敎', U'教'}, {U'靑', U'青'}, {U'淸', U'清'},
+        {U'眞', U'真'}, {U'卽', U'即'}, {U'旣', U'既'}, {U'槪', U'概'}, {U'峯', U'峰'}, {U'羣', U'群'},
+        {U'牀', U'床'}, {U'皐', U'皋'}
+    };
+    // ... and those whose standard form depends on the script
+    constexpr char32_t traditional_variants[][2] = {
+        {U'凖', U'準'}, {U'綫', U'線'}, {U'鷄', U'雞'}, {U'敍', U'敘'}, {U'隣', U'鄰'}, {U'擧', U'舉'},
+        {U'嶋', U'島'}, {U'竝', U'並'}, {U'凉', U'涼'}, {U'册', U'冊'}
+    };
+    constexpr char32_t simplified_variants[][2] = {
+        {U'凖', U'准'}, {U'綫', U'线'}, {U'鷄', U'鸡'}, {U'敍', U'叙'}, {U'隣', U'邻'}, {U'擧', U'举'},
+        {U'嶋', U'岛'}, {U'竝', U'并'}
+    };
+
+    bool simplifiedSource(const ZhoConfig config) {
+        return config == ZhoConfig::S2t || config == ZhoConfig::S2tw || config == ZhoConfig::S2twp ||
+               config == ZhoConfig::S2hk;
+    }
+
+    // U+FF66..U+FF9D, half-width to full-width katakana
+    constexpr char16_t halfwidth_katakana[] = {
+        0x30F2, 0x30A1, 0x30A3, 0x30A5, 0x30A7, 0x30A9, 0x30E3, 0x30E5, 0x30E7, 0x30C3,
+        0x30FC, 0x30A2, 0x30A4, 0x30A6, 0x30A8, 0x30AA, 0x30AB, 0x30AD, 0x30AF, 0x30B1,
+        0x30B3, 0x30B5, 0x30B7, 0x30B9, 0x30BB, 0x30BD, 0x30BF, 0x30C1, 0x30C4, 0x30C6,
+        0x30C8, 0x30CA, 0x30CB, 0x30CC, 0x30CD, 0x30CE, 0x30CF, 0x30D2, 0x30D5, 0x30D8,
+        0x30DB, 0x30DE, 0x30DF, 0x30E0, 0x30E1, 0x30E2, 0x30E4, 0x30E6, 0x30E8, 0x30E9,
+        0x30EA, 0x30EB, 0x30EC, 0x30ED, 0x30EF, 0x30F3
+    };
+
+    // ASCII punctuation given its full-width form after CJK text
+    constexpr char widened_punctuation[] = ",!?:;()";
+    // Open parentheses remembered for pairing; deeper ones are forgotten
+    constexpr size_t max_open_parens = 64;
+    // Marks looked back over for the character they belong to, as in the
+    // stream-safe text format
+    constexpr int max_marks_back = 30;
+
+    struct Range {
+        char32_t first;
+        char32_t last;
+    };
+
+    // Combining marks and conjoining jamo, which may compose with what
+    // precedes them or need reordering: the combining blocks, plus the
+    // NFC_Quick_Check=Maybe characters outside them (UAX #15)
+    constexpr Range combining_ranges[] = {
+        {0x0300, 0x036F}, {0x0653, 0x0655}, {0x093C, 0x093C}, {0x09BE, 0x09BE}, {0x09D7, 0x09D7},
+        {0x0B3E, 0x0B3E}, {0x0B56, 0x0B57}, {0x0BBE, 0x0BBE}, {0x0BD7, 0x0BD7}, {0x0C56, 0x0C56},
+        {0x0CC2, 0x0CC2}, {0x0CD5, 0x0CD6}, {0x0D3E, 0x0D3E}, {0x0D57, 0x0D57}, {0x0DCA, 0x0DCA},
+        {0x0DCF, 0x0DCF}, {0x0DDF, 0x0DDF}, {0x102E, 0x102E}, {0x1100, 0x11FF}, {0x1AB0, 0x1AFF},
+        {0x1B35, 0x1B35}, {0x1DC0, 0x1DFF}, {0x20D0, 0x20FF}, {0x3099, 0x309A}, {0xFE20, 0xFE2F},
+        {0x110BA, 0x110BA}, {0x11127, 0x11127}, {0x1133E, 0x1133E}, {0x11357, 0x11357}, {0x114B0, 0x114B0},
+        {0x114BA, 0x114BA}, {0x114BD, 0x114BD}, {0x115AF, 0x115AF}, {0x11930, 0x11930}
+    };
+
+    // NFC_Quick_Check=No: characters NFC replaces outright. Singletons (CJK
+    // compatibility ideographs, U+1F71, ...), composition exclusions (U+0958,
+    // U+FB1D, ...) and non-starter decompositions.
+    constexpr Range nfc_replaced_ranges[] = {
+        {0x0340, 0x0341}, {0x0343, 0x0344}, {0x0374, 0x0374}, {0x037E, 0x037E}, {0x0387, 0x0387},
+        {0x0958, 0x095F}, {0x09DC, 0x09DD}, {0x09DF, 0x09DF}, {0x0A33, 0x0A33}, {0x0A36, 0x0A36},
+        {0x0A59, 0x0A5B}, {0x0A5E, 0x0A5E}, {0x0B5C, 0x0B5D}, {0x0F43, 0x0F43}, {0x0F4D, 0x0F4D},
+        {0x0F52, 0x0F52}, {0x0F57, 0x0F57}, {0x0F5C, 0x0F5C}, {0x0F69, 0x0F69}, {0x0F73, 0x0F73},
+        {0x0F75, 0x0F76}, {0x0F78, 0x0F78}, {0x0F81, 0x0F81}, {0x0F93, 0x0F93}, {0x0F9D, 0x0F9D},
+        {0x0FA2, 0x0FA2}, {0x0FA7, 0x0FA7}, {0x0FAC, 0x0FAC}, {0x0FB9, 0x0FB9}, {0x1F71, 0x1F71},
+        {0x1F73, 0x1F73}, {0x1F75, 0x1F75}, {0x1F77, 0x1F77}, {0x1F79, 0x1F79}, {0x1F7B, 0x1F7B},
+        {0x1F7D, 0x1F7D}, {0x1FBB, 0x1FBB}, {0x1FBE, 0x1FBE}, {0x1FC9, 0x1FC9}, {0x1FCB, 0x1FCB},
+        {0x1FD3, 0x1FD3}, {0x1FDB, 0x1FDB}, {0x1FE3, 0x1FE3}, {0x1FEB, 0x1FEB}, {0x1FEE, 0x1FEF},
+        {0x1FF9, 0x1FF9}, {0x1FFB, 0x1FFB}, {0x1FFD, 0x1FFD}, {0x2000, 0x2001}, {0x2126, 0x2126},
+        {0x212A, 0x212B}, {0x2329, 0x232A}, {0x2ADC, 0x2ADC}, {0xF900, 0xFA0D}, {0xFA10, 0xFA10},
+        {0xFA12, 0xFA12}, {0xFA15, 0xFA1E}, {0xFA20, 0xFA20}, {0xFA22, 0xFA22}, {0xFA25, 0xFA26},
+        {0xFA2A, 0xFA6D}, {0xFA70, 0xFAD9}, {0xFB1D, 0xFB1D}, {0xFB1F, 0xFB1F}, {0xFB2A, 0xFB36},
+        {0xFB38, 0xFB3C}, {0xFB3E, 0xFB3E}, {0xFB40, 0xFB41}, {0xFB43, 0xFB44}, {0xFB46, 0xFB4E},
+        {0x1D15E, 0x1D164}, {0x1D1BB, 0x1D1C0}, {0x2F800, 0x2FA1D}
+    };
+
+    template <size_t N>
+    bool inRanges(const Range (&ranges)[N], const char32_t code_point) {
+        const Range *const after = std::upper_bound(std::begin(ranges), std::end(ranges), code_point,
+                                                    [](const char32_t c, const Range &range) {
+                                                        return c < range.first;
+                                                    });
+        return after != std::begin(ranges) && code_point <= (after - 1)->last;
+    }
+
+    // Decodes the character at i; invalid bytes come back as U+FFFD, one
+    // byte long, and are copied unchanged.
+    char32_t decode(const std::string_view text, const size_t i, size_t &length) {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        length = lead < 0x80 ? 1
+                 : (lead & 0xE0) == 0xC0 ? 2
+                 : (lead & 0xF0) == 0xE0 ? 3
+                 : (lead & 0xF8) == 0xF0 ? 4
+                 : 0;
+        if (length == 0 || i + length > text.size()) {
+            length = 1;
+            return 0xFFFD;
+        }
+        char32_t code_point = length == 1 ? lead : lead & (0x7F >> length);
+        for (size_t k = 1; k < length; ++k) {
+            code_point = code_point << 6 | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+        }
+        return code_point;
+    }
+
+    void appendUtf8(const char32_t code_point, std::string &out) {
+        if (code_point < 0x80) {
+            out += static_cast<char>(code_point);
+        } else if (code_point < 0x800) {
+            out += static_cast<char>(0xC0 | code_point >> 6);
+            out += static_cast<char>(0x80 | (code_point & 0x3F));
+        } else if (code_point < 0x10000) {
+            out += static_cast<char>(0xE0 | code_point >> 12);
+            out += static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (code_point & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | code_point >> 18);
+            out += static_cast<char>(0x80 | (code_point >> 12 & 0x3F));
+            out += static_cast<char>(0x80 | (code_point >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (code_point & 0x3F));
+        }
+    }
+
+    // Start of the last character in out
+    size_t lastCharStart(const std::string &out) {
+        size_t start = out.size();
+        while (start > 0 && (static_cast<unsigned char>(out[--start]) & 0xC0) == 0x80) {
+        }
+        return start;
+    }
+
+    bool isCjk(const char32_t code_point) {
+        return (code_point >= 0x2E80 && code_point < 0xA000) || (code_point >= 0xF900 && code_point < 0xFB00) ||
+               code_point >= 0x20000;
+    }
+
+    bool isCombining(const char32_t code_point) {
+        return code_point >= 0x0300 && inRanges(combining_ranges, code_point);
+    }
+
+    bool isNfcReplaced(const char32_t code_point) {
+        return code_point >= 0x0340 && inRanges(nfc_replaced_ranges, code_point);
+    }
+
+    // Start of the last character in out that is not a combining mark,
+    // from floor on; the last character if there is none
+    size_t lastStarterStart(const std::string &out, const size_t floor) {
+        size_t start = lastCharStart(out);
+        size_t length;
+        for (int marks = 0; marks < max_marks_back && start > floor && isCombining(decode(out, start, length));
+             ++marks) {
+            do {
+                --start;
+            } while (start > floor && (static_cast<unsigned char>(out[start]) & 0xC0) == 0x80);
+        }
+        return std::max(start, floor);
+    }
+
+    // Replaces the last character of out with the marks after it, plus
+    // text (combining characters), by their NFC form.
+    void composeWithLast(const std::string_view text, std::string &out) {
+        const size_t start = lastStarterStart(out, 0);
+        const QString span = QString::fromUtf8(out.data() + start, static_cast<qsizetype>(out.size() - start)) +
+                             QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size()));
+        out.resize(start);
+        out += span.normalized(QString::NormalizationForm_C).toStdString();
+    }
+
+    // The character before the next one appended to out, whose text
+    // started at begin
+    char32_t previousChar(const std::string &out, const size_t begin, const NormalizeState &state) {
+        if (out.size() == begin) {
+            return state.last;
+        }
+        size_t length;
+        return decode(out, lastCharStart(out), length);
+    }
+
+    void openParen(NormalizeState &state, const bool widened) {
+        if (state.widenedParens.size() == max_open_parens) {
+            state.widenedParens.erase(state.widenedParens.begin());
+        }
+        state.widenedParens.push_back(widened);
+    }
+
+    // Whether the closing parenthesis pairs with a widened one; false when
+    // none is open
+    bool closeParen(NormalizeState &state, bool &widened) {
+        if (state.widenedParens.empty()) {
+            return false;
+        }
+        widened = state.widenedParens.back();
+        state.widenedParens.pop_back();
+        return true;
+    }
+
+    // Whether the character needs the slow path under options
+    bool mayChange(const char32_t code_point, const NormalizeOptions &options) {
+        if (options.variants != nullptr && options.variants->contains(code_point)) {
+            return true;
+        }
+        if (options.nfc && (isCombining(code_point) || isNfcReplaced(code_point))) {
+            return true;
+        }
+        if (code_point >= 0xFF01 && code_point <= 0xFF9F) {
+            return options.foldWidth || options.punctuationWidth != PunctuationWidth::Keep;
+        }
+        return options.punctuationWidth == PunctuationWidth::Full && code_point > 0 && code_point < 0x80 &&
+               std::strchr(widened_punctuation, static_cast<int>(code_point)) != nullptr;
+    }
+}
+
+std::shared_ptr<const VariantTable> VariantTable::load(const ZhoConfig config, const QString &file) {
+    auto table = std::make_shared<VariantTable>();
+    for (const auto &[variant, standard]: shared_variants) {
+        table->add(variant, standard);
+    }
+    if (simplifiedSource(config)) {
+        for (const auto &[variant, standard]: simplified_variants) {
+            table->add(variant, standard);
+        }
+    } else {
+        for (const auto &[variant, standard]: traditional_variants) {
+            table->add(variant, standard);
+        }
+    }
+
+    QFile input(file);
+    if (!file.isEmpty() && input.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!input.atEnd()) {
+            const QString line = QString::fromUtf8(input.readLine()).trimmed();
+            if (line.isEmpty() || line.startsWith('#')) {
+                continue;
+            }
+            const QList<uint> chars = line.simplified().toUcs4();
+            // "variant standard": the first character of each field
+            const qsizetype space = chars.indexOf(' ');
+            if (space == 1 && chars.size() > 2) {
+                table->add(chars[0], chars[2]);
+            }
+        }
+    }
+    return table;
+}
+
+void VariantTable::add(const char32_t variant, const char32_t standard) {
+    if (variant < 0x10000) {
+        bmp.set(variant);
+    }
+    map[variant] = standard;
+}
+
+void setTextNormalization(const NormalizeOptions &options) {
+    std::lock_guard lock(options_mutex);
+    current_options = options;
+    current_options.variants.reset();
+}
+
+NormalizeOptions textNormalization() {
+    std::lock_guard lock(options_mutex);
+    return current_options;
+}
+
+NormalizeOptions textNormalization(const ZhoConfig config) {
+    std::lock_guard lock(options_mutex);
+    NormalizeOptions options = current_options;
+    if (options.foldVariants) {
+        auto &table = variant_tables[static_cast<int>(config)];
+        if (table == nullptr) {
+            table = VariantTable::load(
+                config, variant_directory.isEmpty()
+                            ? QString()
+                            : QDir(variant_directory).filePath(QString(configName(config)) + ".txt"));
+        }
+        options.variants = table;
+    }
+    return options;
+}
+
+void setVariantDirectory(const QString &directory) {
+    std::lock_guard lock(options_mutex);
+    variant_directory = directory;
+    for (auto &table: variant_tables) {
+        table.reset();
+    }
+}
+
+QString variantDirectory() {
+    std::lock_guard lock(options_mutex);
+    return variant_directory;
+}
+
+void appendNormalized(const std::string_view text, const NormalizeOptions &options, std::string &out,
+                      NormalizeState *state) {
+    // What the previous chunk held back comes first
+    const size_t begin = out.size();
+    if (state != nullptr) {
+        finishNormalized(*state, out);
+    }
+    if (!options.isActive()) {
+        out.append(text);
+        return;
+    }
+    NormalizeState first_chunk;
+    NormalizeState &context = state != nullptr ? *state : first_chunk;
+    const bool widen = options.punctuationWidth == PunctuationWidth::Full;
+    const bool narrow = options.punctuationWidth == PunctuationWidth::Half;
+    const VariantTable *const variants = options.variants.get();
+    out.reserve(out.size() + text.size());
+    size_t run = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        // Fast paths: ASCII 8 bytes at a time (unless punctuation may
+        // widen), and ideographs U+4000..U+9FFF, which only change if they
+        // are variants
+        if (lead < 0x80 && !widen) {
+            while (i + 8 <= text.size()) {
+                uint64_t word;
+                std::memcpy(&word, text.data() + i, sizeof(word));
+                if (word & 0x8080808080808080ULL) {
+                    break;
+                }
+                i += 8;
+            }
+            while (i < text.size() && static_cast<unsigned char>(text[i]) < 0x80) {
+                ++i;
+            }
+            continue;
+        }
+        if (lead >= 0xE4 && lead <= 0xE9 && i + 3 <= text.size()) {
+            if (variants == nullptr ||
+                !variants->contains((lead & 0x0F) << 12 | (static_cast<unsigned char>(text[i + 1]) & 0x3F) << 6 |
+                                    (static_cast<unsigned char>(text[i + 2]) & 0x3F))) {
+                i += 3;
+                continue;
+            }
+        }
+
+        size_t length;
+        const char32_t code_point = decode(text, i, length);
+        if (!mayChange(code_point, options)) {
+            i += length;
+            continue;
+        }
+        out.append(text.substr(run, i - run));
+
+        if (variants != nullptr && variants->contains(code_point)) {
+            appendUtf8(variants->fold(code_point), out);
+            i += length;
+        } else if (options.nfc && isCombining(code_point)) {
+            // The whole run of marks composes with the preceding character
+            size_t end = i + length;
+            size_t next_length;
+            while (end < text.size() && isCombining(decode(text, end, next_length))) {
+                end += next_length;
+            }
+            composeWithLast(text.substr(i, end - i), out);
+            i = end;
+        } else if (options.nfc && isNfcReplaced(code_point)) {
+            out.append(text.substr(i, length));
+            composeWithLast({}, out);
+            i += length;
+        } else if ((code_point >= 0xFF10 && code_point <= 0xFF19) || (code_point >= 0xFF21 && code_point <= 0xFF3A) ||
+                   (code_point >= 0xFF41 && code_point <= 0xFF5A)) {
+            if (options.foldWidth) {
+                out += static_cast<char>(code_point - 0xFEE0);
+            } else {
+                out.append(text.substr(i, length));
+            }
+            i += length;
+        } else if (code_point >= 0xFF01 && code_point <= 0xFF5E) {
+            // Remaining full-width ASCII is punctuation
+            bool widened;
+            if (widen && code_point == 0xFF08) {
+                openParen(context, true);
+            } else if (widen && code_point == 0xFF09) {
+                closeParen(context, widened);
+            }
+            if (narrow) {
+                out += static_cast<char>(code_point - 0xFEE0);
+            } else {
+                out.append(text.substr(i, length));
+            }
+            i += length;
+        } else if (code_point >= 0xFF61 && code_point <= 0xFF64) {
+            constexpr char32_t wide[] = {0x3002, 0x300C, 0x300D, 0x3001};
+            if (widen || options.foldWidth) {
+                appendUtf8(wide[code_point - 0xFF61], out);
+            } else {
+                out.append(text.substr(i, length));
+            }
+            i += length;
+        } else if (options.foldWidth && code_point >= 0xFF66 && code_point <= 0xFF9D) {
+            appendUtf8(halfwidth_katakana[code_point - 0xFF66], out);
+            i += length;
+        } else if (options.foldWidth && (code_point == 0xFF9E || code_point == 0xFF9F)) {
+            // Half-width voiced marks combine with the kana before them
+            std::string mark;
+            appendUtf8(code_point == 0xFF9E ? 0x3099 : 0x309A, mark);
+            composeWithLast(mark, out);
+            i += length;
+        } else if (widen && code_point < 0x80) {
+            // A closing parenthesis follows its opening one, so 中文(abc)
+            // keeps a matching pair
+            bool wide;
+            if (code_point != ')' || !closeParen(context, wide)) {
+                wide = isCjk(previousChar(out, begin, context));
+            }
+            if (code_point == '(') {
+                openParen(context, wide);
+            }
+            if (wide) {
+                appendUtf8(0xFF00 + code_point - 0x20, out);
+            } else {
+                out += static_cast<char>(code_point);
+            }
+            i += length;
+        } else {
+            out.append(text.substr(i, length));
+            i += length;
+        }
+        run = i;
+    }
+    out.append(text.substr(run));
+    if (out.size() > begin) {
+        size_t length;
+        context.last = decode(out, lastCharStart(out), length);
+    }
+    // A line break takes no marks
+    if (state != nullptr && options.nfc && out.size() > begin && out.back() != '\n') {
+        const size_t held = lastStarterStart(out, begin);
+        context.held.assign(out, held);
+        out.resize(held);
+    }
+}
+
+void finishNormalized(NormalizeState &state, std::string &out) {
+    out += state.held;
+    state.held.clear();
+}
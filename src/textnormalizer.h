@@ -0,0 +1,112 @@
+#ifndef TEXTNORMALIZER_H
+#define TEXTNORMALIZER_H
+
+#include <QString>
+#include <bitset>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "zhoconfig.h"
+
+enum class PunctuationWidth {
+    Keep,
+    Full, // ，！？：；（） after CJK text (a closing parenthesis as its
+          // opening one), ｡｢｣､ -> 。「」、
+    Half  // ！＃（），．： ... -> !#(),.:
+};
+
+// Variant characters (異體字) common in scanned and web text, which the
+// dictionaries do not list, mapped to the standard form they do. Each
+// config has its own table: the built-in entries for its source script
+// (simplified or traditional targets differ), then the lines of
+// <variantDirectory()>/<config>.txt, "variant standard" per line with #
+// comments, which add entries or override built-in ones.
+class VariantTable {
+public:
+    static std::shared_ptr<const VariantTable> load(ZhoConfig config, const QString &file);
+
+    bool contains(const char32_t code_point) const {
+        return code_point < 0x10000 ? bmp.test(code_point) : map.count(code_point) != 0;
+    }
+
+    // Call only for characters the table contains
+    char32_t fold(const char32_t code_point) const { return map.at(code_point); }
+
+    size_t size() const { return map.size(); }
+
+    const std::unordered_map<char32_t, char32_t> &entries() const { return map; }
+
+private:
+    void add(char32_t variant, char32_t standard);
+
+    // Membership of BMP characters, so ideographs not in the table cost a
+    // bit test
+    std::bitset<0x10000> bmp;
+    std::unordered_map<char32_t, char32_t> map;
+};
+
+// Optional clean-up applied to conversion input so dictionary lookups see
+// one form of each character:
+//   nfc       Unicode NFC: composes decomposed sequences and replaces
+//             the characters NFC never keeps (CJK compatibility ideographs,
+//             composition exclusions such as U+0958 and U+FB1D, singletons
+//             such as U+1F71); marks are put in canonical order within the
+//             combining blocks textnormalizer.cpp lists
+//   foldWidth full-width Latin letters and digits to ASCII, half-width
+//             katakana to full width
+//   foldVariants variant characters to standard forms (see VariantTable)
+struct NormalizeOptions {
+    bool nfc = false;
+    bool foldWidth = false;
+    PunctuationWidth punctuationWidth = PunctuationWidth::Keep;
+    bool foldVariants = false;
+    // The table of one config, set by textNormalization(config)
+    std::shared_ptr<const VariantTable> variants;
+
+    bool isActive() const {
+        return nfc || foldWidth || punctuationWidth != PunctuationWidth::Keep || variants != nullptr;
+    }
+};
+
+// Process-wide options used by the batch and stream converters.
+void setTextNormalization(const NormalizeOptions &options);
+
+NormalizeOptions textNormalization();
+
+// The options for converting with config, with its variant table when
+// foldVariants is on. Tables load on first use and are shared.
+NormalizeOptions textNormalization(ZhoConfig config);
+
+// Where per-config variant files are read from; changing it reloads the
+// tables.
+void setVariantDirectory(const QString &directory);
+
+QString variantDirectory();
+
+// What appendNormalized() carries from one chunk of a text to the next, so
+// that where the text is split does not change the result: the character
+// before the chunk, for each parenthesis still open whether it was
+// widened, and with NFC the chunk's last character and its marks, held
+// back because marks at the start of the next chunk may compose with it.
+struct NormalizeState {
+    char32_t last = 0;
+    std::vector<bool> widenedParens;
+    std::string held;
+};
+
+// Appends text to out, normalized. Meant to replace the copy each
+// conversion path already makes of its chunk, rather than adding a pass:
+// runs of ASCII and of CJK ideographs are copied in bulk, and only
+// characters that may change are decoded. With a variant table,
+// ideographs take one bit test each. Pass the same state for consecutive
+// chunks of one text, and call finishNormalized() after the last; without
+// one, text is taken to be the whole text.
+void appendNormalized(std::string_view text, const NormalizeOptions &options, std::string &out,
+                      NormalizeState *state = nullptr);
+
+// Appends what state still holds back at the end of the text.
+void finishNormalized(NormalizeState &state, std::string &out);
+
+#endif // TEXTNORMALIZER_H
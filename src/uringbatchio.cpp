@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include "uringbatchio.h"
+
+#ifdef ZHO_HAVE_IO_URING
+#include <fcntl.h>
+#include <liburing.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+struct UringBatchIO::Ring {
+    io_uring uring{};
+    void *buffers = nullptr;
+    bool initialized = false;
+    // Registration needs locked memory (RLIMIT_MEMLOCK); without it the
+    // slots are used as plain buffers
+    bool registered = false;
+
+    ~Ring() {
+        reset();
+        std::free(buffers);
+    }
+
+    // Tears the ring down after a failed wait, so completions still in
+    // flight cannot be taken for the next batch's. The object is invalid
+    // afterwards and callers use their standard I/O path.
+    void reset() {
+        if (initialized) {
+            io_uring_queue_exit(&uring);
+            initialized = false;
+            registered = false;
+        }
+    }
+};
+
+namespace {
+    // user_data of the data phase: file index << 2 | operation
+    constexpr uint64_t op_data = 0;
+    constexpr uint64_t op_close = 1;
+    constexpr uint64_t op_fadvise = 2;
+    constexpr uint64_t op_mask = 3;
+
+    // Submits everything queued and collects `expected` completions, calling
+    // handle(user_data, res) for each. Adds the io_uring_enter calls made to
+    // syscalls. False if waiting failed before all completions were in.
+    template<typename Handler>
+    bool submitAndReap(io_uring *uring, const unsigned expected, uint64_t &syscalls, Handler handle) {
+        ++syscalls;
+        io_uring_submit_and_wait(uring, expected);
+        for (unsigned reaped = 0; reaped < expected; ++reaped) {
+            io_uring_cqe *cqe = nullptr;
+            if (io_uring_peek_cqe(uring, &cqe) != 0) {
+                int result;
+                do {
+                    ++syscalls;
+                    result = io_uring_wait_cqe(uring, &cqe);
+                } while (result == -EINTR);
+                if (result != 0) {
+                    return false;
+                }
+            }
+            handle(cqe->user_data, cqe->res);
+            io_uring_cqe_seen(uring, cqe);
+        }
+        return true;
+    }
+}
+
+UringBatchIO::UringBatchIO(const unsigned depth, const size_t slot_size)
+    : ring(std::make_unique<Ring>()), batchDepth(depth), slot(slot_size) {
+    // Every file needs up to three SQEs in the data phase (read, fadvise, close)
+    if (io_uring_queue_init(depth * 3, &ring->uring, 0) != 0) {
+        return;
+    }
+    ring->initialized = true;
+
+    if (posix_memalign(&ring->buffers, 4096, static_cast<size_t>(depth) * slot_size) != 0) {
+        ring->buffers = nullptr;
+        return;
+    }
+    std::vector<iovec> iovecs(depth);
+    for (unsigned i = 0; i < depth; ++i) {
+        iovecs[i].iov_base = static_cast<char *>(ring->buffers) + static_cast<size_t>(i) * slot_size;
+        iovecs[i].iov_len = slot_size;
+    }
+    ring->registered = io_uring_register_buffers(&ring->uring, iovecs.data(), depth) == 0;
+}
+
+UringBatchIO::~UringBatchIO() = default;
+
+bool UringBatchIO::isSupported() {
+    io_uring probe{};
+    if (io_uring_queue_init(2, &probe, 0) != 0) {
+        return false;
+    }
+    io_uring_queue_exit(&probe);
+    return true;
+}
+
+bool UringBatchIO::isValid() const {
+    return ring->initialized && ring->buffers != nullptr;
+}
+
+void UringBatchIO::readBatch(const std::vector<std::string> &paths, std::vector<UringReadResult> &results) {
+    const auto count = static_cast<unsigned>(paths.size());
+    results.assign(count, {});
+    if (!isValid() || count > batchDepth) {
+        for (auto &result: results) {
+            result.error = -EINVAL;
+        }
+        return;
+    }
+
+    // Phase 1: open all files. Results stay -ECANCELED until their
+    // completion is in.
+    std::vector<int> fds(count, -1);
+    for (unsigned i = 0; i < count; ++i) {
+        io_uring_sqe *sqe = io_uring_get_sqe(&ring->uring);
+        io_uring_prep_openat(sqe, AT_FDCWD, paths[i].c_str(), O_RDONLY | O_CLOEXEC, 0);
+        sqe->user_data = i;
+        results[i].error = -ECANCELED;
+    }
+    if (!submitAndReap(&ring->uring, count, counters.syscalls, [&](const uint64_t data, const int res) {
+        results[data].error = std::min(res, 0);
+        fds[data] = res;
+    })) {
+        ring->reset();
+        for (unsigned i = 0; i < count; ++i) {
+            if (fds[i] >= 0) {
+                ::close(fds[i]);
+                results[i].error = -ECANCELED;
+            }
+        }
+        return;
+    }
+
+    // Phase 2: read each file into its registered slot, drop its pages from
+    // the cache (batch inputs are read once) and close it. Hard links keep the
+    // chain going even if the read fails, so no descriptor leaks.
+    unsigned queued = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        char *buffer = static_cast<char *>(ring->buffers) + static_cast<size_t>(i) * slot;
+        io_uring_sqe *sqe = io_uring_get_sqe(&ring->uring);
+        if (ring->registered) {
+            io_uring_prep_read_fixed(sqe, fds[i], buffer, static_cast<unsigned>(slot), 0, static_cast<int>(i));
+        } else {
+            io_uring_prep_read(sqe, fds[i], buffer, static_cast<unsigned>(slot), 0);
+        }
+        sqe->flags |= IOSQE_IO_HARDLINK;
+        sqe->user_data = static_cast<uint64_t>(i) << 2 | op_data;
+
+        sqe = io_uring_get_sqe(&ring->uring);
+        io_uring_prep_fadvise(sqe, fds[i], 0, 0, POSIX_FADV_DONTNEED);
+        sqe->flags |= IOSQE_IO_HARDLINK;
+        sqe->user_data = static_cast<uint64_t>(i) << 2 | op_fadvise;
+
+        sqe = io_uring_get_sqe(&ring->uring);
+        io_uring_prep_close(sqe, fds[i]);
+        sqe->user_data = static_cast<uint64_t>(i) << 2 | op_close;
+        results[i].error = -ECANCELED;
+        queued += 3;
+    }
+    if (queued == 0) {
+        return;
+    }
+    // The ring owns the descriptors now; after a failed wait their closes
+    // may still be in flight, so they are not closed here
+    if (!submitAndReap(&ring->uring, queued, counters.syscalls, [&](const uint64_t data, const int res) {
+        if ((data & op_mask) != op_data) {
+            return;
+        }
+        const auto i = static_cast<unsigned>(data >> 2);
+        results[i].error = 0;
+        if (res < 0) {
+            results[i].error = res;
+        } else if (static_cast<size_t>(res) >= slot) {
+            // Possibly larger than the slot: let the caller read it normally
+            results[i].error = -EFBIG;
+        } else {
+            results[i].data.assign(static_cast<char *>(ring->buffers) + static_cast<size_t>(i) * slot, res);
+            counters.bytesRead += res;
+            ++counters.files;
+        }
+    })) {
+        ring->reset();
+    }
+}
+
+void UringBatchIO::writeBatch(const std::vector<UringWriteRequest> &requests, std::vector<int> &errors) {
+    const auto count = static_cast<unsigned>(requests.size());
+    errors.assign(count, 0);
+    if (!isValid() || count > batchDepth) {
+        errors.assign(count, -EINVAL);
+        return;
+    }
+
+    std::vector<int> fds(count, -1);
+    for (unsigned i = 0; i < count; ++i) {
+        io_uring_sqe *sqe = io_uring_get_sqe(&ring->uring);
+        io_uring_prep_openat(sqe, AT_FDCWD, requests[i].path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                             0644);
+        sqe->user_data = i;
+        errors[i] = -ECANCELED;
+    }
+    if (!submitAndReap(&ring->uring, count, counters.syscalls, [&](const uint64_t data, const int res) {
+        errors[data] = std::min(res, 0);
+        fds[data] = res;
+    })) {
+        ring->reset();
+        for (unsigned i = 0; i < count; ++i) {
+            if (fds[i] >= 0) {
+                ::close(fds[i]);
+                errors[i] = -ECANCELED;
+            }
+        }
+        return;
+    }
+
+    unsigned queued = 0;
+    for (unsigned i = 0; i < count; ++i) {
+        if (fds[i] < 0) {
+            continue;
+        }
+        const std::string_view data = requests[i].data;
+        io_uring_sqe *sqe = io_uring_get_sqe(&ring->uring);
+        if (data.size() <= slot && ring->registered) {
+            // Copying into the registered slot saves the kernel from pinning
+            // the user pages on every write.
+            char *buffer = static_cast<char *>(ring->buffers) + static_cast<size_t>(i) * slot;
+            std::memcpy(buffer, data.data(), data.size());
+            io_uring_prep_write_fixed(sqe, fds[i], buffer, static_cast<unsigned>(data.size()), 0,
+                                      static_cast<int>(i));
+        } else {
+            io_uring_prep_write(sqe, fds[i], data.data(), static_cast<unsigned>(data.size()), 0);
+        }
+        sqe->flags |= IOSQE_IO_HARDLINK;
+        sqe->user_data = static_cast<uint64_t>(i) << 2 | op_data;
+
+        sqe = io_uring_get_sqe(&ring->uring);
+        io_uring_prep_close(sqe, fds[i]);
+        sqe->user_data = static_cast<uint64_t>(i) << 2 | op_close;
+        errors[i] = -ECANCELED;
+        queued += 2;
+    }
+    if (queued == 0) {
+        return;
+    }
+    // The write completes before its linked close
+    if (!submitAndReap(&ring->uring, queued, counters.syscalls, [&](const uint64_t data, const int res) {
+        const auto i = static_cast<unsigned>(data >> 2);
+        if ((data & op_mask) == op_data) {
+            if (res < 0) {
+                errors[i] = res;
+            } else if (static_cast<size_t>(res) != requests[i].data.size()) {
+                errors[i] = -EIO;
+            } else {
+                errors[i] = 0;
+                counters.bytesWritten += res;
+            }
+        } else if (res < 0 && errors[i] == 0) {
+            errors[i] = res;
+        }
+    })) {
+        ring->reset();
+    }
+}
+
+#else
+
+struct UringBatchIO::Ring {
+};
+
+UringBatchIO::UringBatchIO(const unsigned depth, const size_t slot_size)
+    : ring(std::make_unique<Ring>()), batchDepth(depth), slot(slot_size) {
+}
+
+UringBatchIO::~UringBatchIO() = default;
+
+bool UringBatchIO::isSupported() {
+    return false;
+}
+
+bool UringBatchIO::isValid() const {
+    return false;
+}
+
+void UringBatchIO::readBatch(const std::vector<std::string> &paths, std::vector<UringReadResult> &results) {
+    results.assign(paths.size(), {});
+    for (auto &result: results) {
+        result.error = -ENOSYS;
+    }
+}
+
+void UringBatchIO::writeBatch(const std::vector<UringWriteRequest> &requests, std::vector<int> &errors) {
+    errors.assign(requests.size(), -ENOSYS);
+}
+
+#endif
+
+unsigned UringBatchIO::depth() const {
+    return batchDepth;
+}
+
+size_t UringBatchIO::slotSize() const {
+    return slot;
+}
+
+const IoStats &UringBatchIO::stats() const {
+    return counters;
+}
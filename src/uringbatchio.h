@@ -0,0 +1,78 @@
+#ifndef URINGBATCHIO_H
+#define URINGBATCHIO_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Batched whole-file reads and writes on Linux io_uring, for batches of many
+// small files where per-file open / read / close / open / write / close
+// syscalls dominate. A batch of opens is submitted with one io_uring_enter,
+// then all reads (into registered buffers where RLIMIT_MEMLOCK allows) with
+// their linked closes with a second one; writes work the same way. Inputs
+// are dropped from the page cache after reading.
+//
+// Only compiled in with ZHO_HAVE_IO_URING (Linux + liburing). Otherwise, or
+// when the running kernel refuses to set up a ring, isSupported() is false
+// and callers use their standard I/O path. A ring whose wait fails is torn
+// down: files without a completion get -ECANCELED and isValid() turns false.
+struct IoStats {
+    uint64_t syscalls = 0;
+    uint64_t files = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+};
+
+struct UringReadResult {
+    std::string data;
+    // 0 on success, otherwise -errno. -EFBIG means the file did not fit into
+    // one buffer slot, -ECANCELED / -EINVAL that the ring gave up on it or is
+    // unusable; either way it has to be read through the standard path.
+    int error = 0;
+};
+
+struct UringWriteRequest {
+    std::string path;
+    std::string_view data;
+};
+
+class UringBatchIO {
+public:
+    static constexpr unsigned default_depth = 256;
+    static constexpr size_t default_slot_size = 64 * 1024;
+
+    explicit UringBatchIO(unsigned depth = default_depth, size_t slot_size = default_slot_size);
+
+    ~UringBatchIO();
+
+    UringBatchIO(const UringBatchIO &) = delete;
+
+    UringBatchIO &operator=(const UringBatchIO &) = delete;
+
+    static bool isSupported();
+
+    bool isValid() const;
+
+    // Maximum number of files per readBatch() / writeBatch() call.
+    unsigned depth() const;
+
+    size_t slotSize() const;
+
+    void readBatch(const std::vector<std::string> &paths, std::vector<UringReadResult> &results);
+
+    // errors[i] is 0 on success, otherwise -errno.
+    void writeBatch(const std::vector<UringWriteRequest> &requests, std::vector<int> &errors);
+
+    const IoStats &stats() const;
+
+private:
+    struct Ring;
+    std::unique_ptr<Ring> ring;
+    unsigned batchDepth;
+    size_t slot;
+    IoStats counters;
+};
+
+#endif // URINGBATCHIO_H
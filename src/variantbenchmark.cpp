@@ -0,0 +1,201 @@
+#include <QElapsedTimer>
+#include <QFile>
+#include <algorithm>
+#include <cstdio>
+#include <unordered_map>
+#include "variantbenchmark.h"
+#include "convertermanager.h"
+#include "resultstore.h"
+#include "textnormalizer.h"
+#include "zhoutilities.h"
+
+namespace {
+    const QString simplified_sample = QString::fromUtf8(
+        u8"每天清晨步行到冰冷的海边，研究所的晚灯真亮，"
+        u8"姊姊即刻关上户门，教我们涉水前往黑色的礁石。\n");
+    const QString traditional_sample = QString::fromUtf8(
+        u8"每天清晨步行到冰冷的海邊，研究所的晚燈真亮，"
+        u8"姊姊即刻關上戶門，說要教我們涉水沿著線路前往黑色的礁石。\n");
+
+    // Variants seen in OCR and Japanese-sourced text, kept apart from the
+    // VariantTable so the corpus does not just invert what folding
+    // applies: some are in the table, some are not, and the hit rate shows
+    // the table's coverage. Standard form first, per source script.
+    constexpr char32_t held_out_shared[][2] = {
+        {U'每', U'毎'}, {U'步', U'歩'}, {U'清', U'淸'}, {U'冰', U'氷'}, {U'研', U'硏'}, {U'晚', U'晩'},
+        {U'真', U'眞'}, {U'姊', U'姉'}, {U'即', U'卽'}, {U'教', U'敎'}, {U'涉', U'渉'}, {U'黑', U'黒'}
+    };
+    constexpr char32_t held_out_simplified[][2] = {{U'户', U'戸'}};
+    constexpr char32_t held_out_traditional[][2] = {{U'戶', U'戸'}, {U'說', U'説'}, {U'線', U'綫'}};
+
+    constexpr size_t chunk_size = 256 * 1024;
+
+    struct Run {
+        double normalizeSeconds = 0;
+        double totalSeconds = 0;
+        std::string output;
+    };
+
+    // Normalizes and converts text chunk by chunk, as the batch converter
+    // does, timing the normalizing copy separately.
+    Run convert(const IConverterBackend *converter, std::string_view text, const ZhoConfig config,
+                const NormalizeOptions &normalize) {
+        Run run;
+        run.output.reserve(text.size() + text.size() / 8);
+        std::string piece;
+        QElapsedTimer total;
+        total.start();
+        qint64 normalize_nsecs = 0;
+        NormalizeState state;
+        while (!text.empty()) {
+            const size_t boundary = find_split_boundary(text, chunk_size);
+            QElapsedTimer timer;
+            timer.start();
+            piece.clear();
+            appendNormalized(text.substr(0, boundary), normalize, piece, &state);
+            if (boundary == text.size()) {
+                finishNormalized(state, piece);
+            }
+            normalize_nsecs += timer.nsecsElapsed();
+            converter->convert(piece.c_str(), config, false, run.output);
+            text.remove_prefix(boundary);
+        }
+        run.totalSeconds = static_cast<double>(total.nsecsElapsed()) / 1e9;
+        run.normalizeSeconds = static_cast<double>(normalize_nsecs) / 1e9;
+        return run;
+    }
+
+    bool isIdeograph(const uint code_point) {
+        return (code_point >= 0x3400 && code_point < 0xA000) || (code_point >= 0xF900 && code_point < 0xFB00) ||
+               code_point >= 0x20000;
+    }
+
+    // Ideographs the converter changed, position by position: characters
+    // its dictionaries know in another form
+    qsizetype dictionaryHits(const std::string &input, const std::string &output) {
+        const QList<uint> before = QString::fromStdString(input).toUcs4();
+        const QList<uint> after = QString::fromStdString(output).toUcs4();
+        qsizetype hits = 0;
+        for (qsizetype i = 0; i < std::min(before.size(), after.size()); ++i) {
+            hits += isIdeograph(before[i]) && after[i] != before[i];
+        }
+        return hits;
+    }
+
+    // Share of CJK characters of reference that output matches, position by
+    // position
+    double hitRate(const std::string &output, const std::string &reference) {
+        const QList<uint> actual = QString::fromStdString(output).toUcs4();
+        const QList<uint> expected = QString::fromStdString(reference).toUcs4();
+        qsizetype ideographs = 0;
+        qsizetype hits = 0;
+        for (qsizetype i = 0; i < std::min(actual.size(), expected.size()); ++i) {
+            if (isIdeograph(expected[i])) {
+                ++ideographs;
+                hits += actual[i] == expected[i];
+            }
+        }
+        return ideographs == 0 ? 0 : 100.0 * static_cast<double>(hits) / static_cast<double>(ideographs);
+    }
+}
+
+int runVariantBenchmark(const VariantBenchmarkOptions &options) {
+    if (options.size <= 0) {
+        std::fprintf(stderr, "Invalid benchmark options\n");
+        return 1;
+    }
+    const bool simplified = options.config == ZhoConfig::S2t || options.config == ZhoConfig::S2tw ||
+                            options.config == ZhoConfig::S2twp || options.config == ZhoConfig::S2hk;
+    QString sample = simplified ? simplified_sample : traditional_sample;
+    if (!options.file.isEmpty()) {
+        QFile file(options.file);
+        if (!file.open(QIODevice::ReadOnly)) {
+            std::fprintf(stderr, "Cannot read %s\n", qPrintable(options.file));
+            return 1;
+        }
+        sample = QString::fromUtf8(file.readAll());
+    }
+    if (sample.isEmpty()) {
+        std::fprintf(stderr, "Empty sample text\n");
+        return 1;
+    }
+
+    NormalizeOptions plain = textNormalization();
+    plain.foldVariants = true;
+    setTextNormalization(plain);
+    const NormalizeOptions normalize = textNormalization(options.config);
+    plain.foldVariants = false;
+    plain.variants.reset();
+
+    // Every standard form in the sample with a held-out variant is written
+    // as that variant
+    std::unordered_map<char32_t, char32_t> to_variant;
+    for (const auto &[standard, variant]: held_out_shared) {
+        to_variant.emplace(standard, variant);
+    }
+    if (simplified) {
+        for (const auto &[standard, variant]: held_out_simplified) {
+            to_variant.emplace(standard, variant);
+        }
+    } else {
+        for (const auto &[standard, variant]: held_out_traditional) {
+            to_variant.emplace(standard, variant);
+        }
+    }
+    size_t in_table = 0;
+    for (const auto &[standard, variant]: to_variant) {
+        in_table += normalize.variants->contains(variant) && normalize.variants->fold(variant) == standard;
+    }
+    QList<uint> clean_chars = sample.toUcs4();
+    QList<uint> variant_chars = clean_chars;
+    qsizetype substituted = 0;
+    for (uint &code_point: variant_chars) {
+        if (const auto found = to_variant.find(code_point); found != to_variant.end()) {
+            code_point = found->second;
+            ++substituted;
+        }
+    }
+    const auto utf8 = [](const QList<uint> &chars) {
+        return QString::fromUcs4(reinterpret_cast<const char32_t *>(chars.constData()), chars.size()).toStdString();
+    };
+    const std::string clean_line = utf8(clean_chars);
+    const std::string variant_line = utf8(variant_chars);
+    std::string clean;
+    std::string corpus;
+    while (corpus.size() < static_cast<size_t>(options.size)) {
+        clean += clean_line;
+        corpus += variant_line;
+    }
+    const double mb = static_cast<double>(corpus.size()) / 1e6;
+    std::printf("Corpus %.1f MB, config %s, %lld of %lld sample characters are variants; %zu of %zu held-out "
+                "variants are in the %zu-entry table\n", mb, configName(options.config),
+                static_cast<long long>(substituted), static_cast<long long>(clean_chars.size()), in_table,
+                to_variant.size(), normalize.variants->size());
+
+    const ConverterLease lease = sharedConverter();
+    if (!lease) {
+        std::fprintf(stderr, "zhoconv: %s\n", qPrintable(ConverterManager::instance().lastError()));
+        return 1;
+    }
+    const std::string reference = convert(lease.get(), clean, options.config, plain).output;
+    const Run without = convert(lease.get(), corpus, options.config, plain);
+    const Run with = convert(lease.get(), corpus, options.config, normalize);
+
+    // Dictionary hits per copy of the sample, for comparison between runs
+    const double copies = static_cast<double>(corpus.size()) / static_cast<double>(variant_line.size());
+    std::printf("%-16s %12s %12s %10s %14s\n", "", "copy MB/s", "total MB/s", "hit rate", "dict hits/copy");
+    std::printf("%-16s %12s %12s %10s %14.1f\n", "clean text", "", "", "",
+                static_cast<double>(dictionaryHits(clean, reference)) / copies);
+    std::printf("%-16s %12.1f %12.1f %9.2f%% %14.1f\n", "no folding", mb / without.normalizeSeconds,
+                mb / without.totalSeconds, hitRate(without.output, reference),
+                static_cast<double>(dictionaryHits(corpus, without.output)) / copies);
+    std::printf("%-16s %12.1f %12.1f %9.2f%% %14.1f\n", "variant folding", mb / with.normalizeSeconds,
+                mb / with.totalSeconds, hitRate(with.output, reference),
+                static_cast<double>(dictionaryHits(corpus, with.output)) / copies);
+    const QString workload = fileWorkload(1, static_cast<qint64>(corpus.size()));
+    appendResult("bench-variants", "no folding", options.config, workload, mb / without.totalSeconds);
+    appendResult("bench-variants", "variant folding", options.config, workload, mb / with.totalSeconds);
+    std::printf("Folding cost: %+.1f%% of conversion time\n",
+                100.0 * (with.normalizeSeconds - without.normalizeSeconds) / without.totalSeconds);
+    return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef VARIANTBENCHMARK_H
+#define VARIANTBENCHMARK_H
+
+#include <QString>
+#include "zhoconfig.h"
+
+struct VariantBenchmarkOptions {
+    QString file;
+    int size = 16 * 1024 * 1024;
+    ZhoConfig config = ZhoConfig::S2t;
+};
+
+// Builds a variant-heavy corpus from a clean text in the config's source
+// script (file, or a built-in sample when file is empty) by substituting
+// variants from a held-out list, independent of the config's VariantTable,
+// for their standard forms, then converts it with and without variant
+// folding. Prints the throughput of the normalizing copy and of the whole
+// conversion for both, the hit rate (the share of CJK characters converted
+// as in the clean text) and the dictionary hits (ideographs the converter
+// changed) per copy of the sample, against those of the clean text.
+int runVariantBenchmark(const VariantBenchmarkOptions &options);
+
+#endif // VARIANTBENCHMARK_H
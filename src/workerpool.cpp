@@ -0,0 +1,293 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QThread>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include "workerpool.h"
+#include "convertermanager.h"
+#include "taskscheduler.h"
+#include "metrics.h"
+#include "textnormalizer.h"
+
+namespace {
+    // Consecutive workers that died before reporting ready, before the pool
+    // gives up on the queue (e.g. missing or broken executable, or a
+    // dictionary that does not load). A worker that crashes on an input
+    // only fails that file.
+    constexpr int max_spawn_failures = 3;
+}
+
+WorkerPool::WorkerPool(QObject *parent)
+    : QObject(parent), workerProgram(defaultProgram()), count(QThread::idealThreadCount()) {
+    watchdog.setInterval(500);
+    connect(&watchdog, &QTimer::timeout, this, &WorkerPool::checkTimeouts);
+}
+
+WorkerPool::~WorkerPool() {
+    for (Worker &worker: workers) {
+        if (worker.process == nullptr) {
+            continue;
+        }
+        worker.process->disconnect(this);
+        // Closing stdin ends the worker loop; kill it if it is stuck in a file
+        worker.process->closeWriteChannel();
+        if (!worker.process->waitForFinished(worker.busy ? 0 : 2000)) {
+            worker.process->kill();
+            worker.process->waitForFinished(1000);
+        }
+    }
+}
+
+void WorkerPool::setProgram(const QString &program) {
+    workerProgram = program;
+}
+
+QString WorkerPool::program() const {
+    return workerProgram;
+}
+
+QString WorkerPool::defaultProgram() {
+#ifdef Q_OS_WIN
+    return QDir(QCoreApplication::applicationDirPath()).filePath("zhoconv.exe");
+#else
+    return QDir(QCoreApplication::applicationDirPath()).filePath("zhoconv");
+#endif
+}
+
+void WorkerPool::setWorkerCount(const int worker_count) {
+    count = std::max(1, worker_count);
+}
+
+int WorkerPool::workerCount() const {
+    return count;
+}
+
+void WorkerPool::setTimeout(const int base_msec, const int msec_per_mib) {
+    timeoutBase = base_msec;
+    timeoutPerMiB = msec_per_mib;
+}
+
+bool WorkerPool::isAvailable() const {
+    const QFileInfo info(workerProgram);
+    return info.isFile() && info.isExecutable();
+}
+
+void WorkerPool::start(const QList<BatchConverter::Job> &jobs, const ZhoConfig config, const bool punctuation) {
+    if (jobs.isEmpty()) {
+        return;
+    }
+    for (int index = 0; index < jobs.size(); ++index) {
+        queue.enqueue({index, jobs.at(index), config, punctuation});
+    }
+    pending += static_cast<int>(jobs.size());
+    spawnFailures = 0;
+
+    // Slots only grow: their indices are captured by the process signal handlers
+    if (workers.size() < count) {
+        workers.resize(count);
+    }
+    for (int slot = 0; slot < workers.size(); ++slot) {
+        if (workers[slot].process == nullptr) {
+            spawn(slot);
+        }
+        dispatch(slot);
+    }
+    watchdog.start();
+}
+
+bool WorkerPool::isRunning() const {
+    return pending > 0;
+}
+
+void WorkerPool::spawn(const int slot) {
+    auto *process = new QProcess(this);
+    process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    connect(process, &QProcess::readyReadStandardOutput, this, [this, slot, process] {
+        if (workers[slot].process == process) {
+            onReadyRead(slot);
+        }
+    });
+    connect(process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished), this, [this, slot, process] {
+        if (workers[slot].process == process) {
+            onWorkerExited(slot);
+        }
+    });
+    connect(process, &QProcess::errorOccurred, this, [this, slot, process](const QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart && workers[slot].process == process) {
+            onWorkerExited(slot);
+        }
+    });
+
+    workers[slot] = Worker();
+    workers[slot].process = process;
+    // Workers run with the scheduler's placement; each converts on its main
+    // thread, so it is heavy work.
+    const CpuPlacement placement = TaskScheduler::instance().placement();
+    QStringList arguments{"--worker", "--nice", QString::number(placement.nice)};
+    if (!placement.cpus.isEmpty()) {
+        arguments << "--cpus" << formatCpuList(placement.cpus);
+    }
+    if (placement.preferPerformanceCores) {
+        arguments << "--performance-cores";
+    }
+    // ... the same backend ...
+    if (const QString backend = ConverterManager::instance().backendName(); backend != default_backend) {
+        arguments << "--backend" << backend;
+    }
+    // ... and the same input normalization
+    const NormalizeOptions normalize = textNormalization();
+    if (normalize.nfc) {
+        arguments << "--nfc";
+    }
+    if (normalize.foldWidth) {
+        arguments << "--fold-width";
+    }
+    if (normalize.punctuationWidth != PunctuationWidth::Keep) {
+        arguments << "--punct-width" << (normalize.punctuationWidth == PunctuationWidth::Full ? "full" : "half");
+    }
+    if (normalize.foldVariants) {
+        arguments << "--fold-variants";
+        if (const QString directory = variantDirectory(); !directory.isEmpty()) {
+            arguments << "--variant-dir" << directory;
+        }
+    }
+    process->start(workerProgram, arguments);
+}
+
+void WorkerPool::dispatch(const int slot) {
+    Worker &worker = workers[slot];
+    if (worker.busy || worker.process == nullptr || queue.isEmpty()) {
+        return;
+    }
+    worker.task = queue.dequeue();
+    worker.busy = true;
+    worker.deadline = timeoutBase + QFileInfo(worker.task.job.input).size() / (1024 * 1024) * timeoutPerMiB;
+    worker.started.start();
+
+    const QJsonObject request{
+        {"id", worker.task.index},
+        {"in", worker.task.job.input},
+        {"out", worker.task.job.output},
+        {"config", configName(worker.task.config)},
+        {"punct", worker.task.punctuation}
+    };
+    worker.process->write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void WorkerPool::onReadyRead(const int slot) {
+    Worker &worker = workers[slot];
+    worker.buffer += worker.process->readAllStandardOutput();
+
+    qsizetype newline;
+    while ((newline = worker.buffer.indexOf('\n')) >= 0) {
+        const QJsonObject response = QJsonDocument::fromJson(worker.buffer.left(newline)).object();
+        worker.buffer.remove(0, newline + 1);
+        if (response.value("ready").toBool()) {
+            worker.ready = true;
+            spawnFailures = 0;
+            qInfo("Worker %d ready: converter loaded in %lld ms, %.1f MiB resident", slot,
+                  static_cast<long long>(response.value("load_ms").toInteger()),
+                  response.value("rss").toDouble() / (1024 * 1024));
+            continue;
+        }
+        if (!worker.busy || response.value("id").toInt(-1) != worker.task.index) {
+            continue;
+        }
+        worker.busy = false;
+        Metrics::observeFile(worker.task.config, worker.started.nsecsElapsed());
+        complete(worker.task, static_cast<BatchConverter::Status>(response.value("status").toInt()));
+    }
+    dispatch(slot);
+}
+
+void WorkerPool::onWorkerExited(const int slot) {
+    Worker &worker = workers[slot];
+    worker.process->deleteLater();
+    worker.process = nullptr;
+
+    if (!worker.ready) {
+        // Never got to its file, which goes back to the front of the queue
+        ++spawnFailures;
+        if (worker.busy) {
+            worker.busy = false;
+            queue.prepend(worker.task);
+        }
+    } else if (worker.busy) {
+        worker.busy = false;
+        qWarning("Worker failed on %s", qPrintable(worker.task.job.input));
+        complete(worker.task, BatchConverter::WorkerFailed);
+    }
+
+    if (queue.isEmpty()) {
+        return;
+    }
+    if (spawnFailures >= max_spawn_failures) {
+        qWarning("Worker %s does not start; abandoning %d queued file(s)", qPrintable(workerProgram),
+                 static_cast<int>(queue.size()));
+        while (!queue.isEmpty()) {
+            complete(queue.dequeue(), BatchConverter::WorkerFailed);
+        }
+        return;
+    }
+    spawn(slot);
+    dispatch(slot);
+}
+
+void WorkerPool::checkTimeouts() {
+    for (Worker &worker: workers) {
+        if (worker.busy && worker.process != nullptr && worker.started.elapsed() > worker.deadline) {
+            qWarning("Worker timed out on %s", qPrintable(worker.task.job.input));
+            // The exit handler reports the file and restarts the worker
+            worker.process->kill();
+        }
+    }
+}
+
+void WorkerPool::complete(const Task &task, const BatchConverter::Status status) {
+    emit fileFinished(task.index, task.job.input, task.job.output, status);
+    if (--pending == 0) {
+        watchdog.stop();
+        emit finished();
+    }
+}
+
+int WorkerPool::runWorker() {
+    QElapsedTimer timer;
+    timer.start();
+    const ConverterLease converter = sharedConverter();
+    if (!converter) {
+        return 1;
+    }
+    // What this process paid for its own copy of the dictionaries
+    const QJsonObject ready{
+        {"ready", true},
+        {"load_ms", timer.elapsed()},
+        {"rss", ConverterManager::residentBytes()}
+    };
+    const QByteArray ready_line = QJsonDocument(ready).toJson(QJsonDocument::Compact) + '\n';
+    std::fwrite(ready_line.constData(), 1, static_cast<size_t>(ready_line.size()), stdout);
+    std::fflush(stdout);
+    std::string line;
+    while (std::getline(std::cin, line)) {
+        const QJsonObject request = QJsonDocument::fromJson(QByteArray::fromStdString(line)).object();
+        ZhoConfig config;
+        const BatchConverter::Status status =
+                parseConfig(request.value("config").toString().toStdString(), config)
+                    ? BatchConverter::convertFile(converter.get(), request.value("in").toString(),
+                                                  request.value("out").toString(), config,
+                                                  request.value("punct").toBool())
+                    : BatchConverter::WorkerFailed;
+
+        const QJsonObject response{{"id", request.value("id")}, {"status", static_cast<int>(status)}};
+        const QByteArray reply = QJsonDocument(response).toJson(QJsonDocument::Compact) + '\n';
+        std::fwrite(reply.constData(), 1, static_cast<size_t>(reply.size()), stdout);
+        std::fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QTimer>
+#include <QVector>
+#include "batchconverter.h"
+
+class QProcess;
+
+// Runs batch jobs in separate `zhoconv --worker` processes, so an input that
+// crashes or hangs the conversion library only takes down one worker. Each
+// worker converts one file at a time and reports back over its stdout pipe,
+// one JSON object per line, after a first line saying it is ready. A worker
+// that dies, or exceeds the file's timeout, is killed and replaced and that
+// file is reported as WorkerFailed; the rest of the queue carries on. Only
+// workers that die before they are ready count as failing to start, and
+// after a few of those in a row the queue is abandoned.
+class WorkerPool : public QObject {
+Q_OBJECT
+
+public:
+    explicit WorkerPool(QObject *parent = nullptr);
+
+    ~WorkerPool() override;
+
+    // Path of the worker executable; defaults to zhoconv next to the running
+    // application.
+    void setProgram(const QString &program);
+
+    QString program() const;
+
+    static QString defaultProgram();
+
+    void setWorkerCount(int count);
+
+    int workerCount() const;
+
+    // Per-file timeout: base plus an allowance per MiB of input.
+    void setTimeout(int base_msec, int msec_per_mib);
+
+    bool isAvailable() const;
+
+    void start(const QList<BatchConverter::Job> &jobs, ZhoConfig config, bool punctuation);
+
+    bool isRunning() const;
+
+    // Runs the worker side of the protocol on stdin / stdout until stdin
+    // closes. Used by `zhoconv --worker`.
+    static int runWorker();
+
+signals:
+    void fileFinished(int index, const QString &input, const QString &output, BatchConverter::Status status);
+
+    void finished();
+
+private:
+    struct Task {
+        int index = 0;
+        BatchConverter::Job job;
+        ZhoConfig config = ZhoConfig::S2t;
+        bool punctuation = false;
+    };
+
+    struct Worker {
+        QProcess *process = nullptr;
+        QByteArray buffer;
+        // Converter loaded, taking requests
+        bool ready = false;
+        bool busy = false;
+        Task task;
+        QElapsedTimer started;
+        qint64 deadline = 0;
+    };
+
+    void spawn(int slot);
+
+    void dispatch(int slot);
+
+    void onReadyRead(int slot);
+
+    void onWorkerExited(int slot);
+
+    void checkTimeouts();
+
+    void complete(const Task &task, BatchConverter::Status status);
+
+    QString workerProgram;
+    QVector<Worker> workers;
+    QQueue<Task> queue;
+    QTimer watchdog;
+    int count;
+    int spawnFailures = 0;
+    int pending = 0;
+    int timeoutBase = 60000;
+    int timeoutPerMiB = 2000;
+};
+
+#endif // WORKERPOOL_H
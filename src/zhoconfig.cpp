@@ -0,0 +1,11 @@
+#include "zhoconfig.h"
+
+bool parseConfig(const std::string_view name, ZhoConfig &config) {
+    for (int i = 0; i < zho_config_count; ++i) {
+        if (name == configName(static_cast<ZhoConfig>(i))) {
+            config = static_cast<ZhoConfig>(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,52 @@
+#ifndef ZHOCONFIG_H
+#define ZHOCONFIG_H
+
+#include <string_view>
+
+// Conversion configs supported by opencc_fmmseg. Code passes these around
+// instead of strings, so an unsupported config cannot be written down; text
+// names are parsed once, where they enter (command line, combo box, worker
+// protocol, settings).
+enum class ZhoConfig {
+    S2t,
+    S2tw,
+    S2twp,
+    S2hk,
+    T2s,
+    T2tw,
+    T2twp,
+    T2hk,
+    Tw2s,
+    Tw2sp,
+    Tw2t,
+    Tw2tp,
+    Hk2s,
+    Hk2t,
+    Jp2t,
+    T2jp
+};
+
+constexpr int zho_config_count = static_cast<int>(ZhoConfig::T2jp) + 1;
+
+// The library's name for config, as a static NUL-terminated string.
+constexpr const char *configName(const ZhoConfig config) {
+    constexpr const char *names[zho_config_count] = {
+        "s2t", "s2tw", "s2twp", "s2hk", "t2s", "t2tw", "t2twp", "t2hk",
+        "tw2s", "tw2sp", "tw2t", "tw2tp", "hk2s", "hk2t", "jp2t", "t2jp"
+    };
+    return names[static_cast<int>(config)];
+}
+
+bool parseConfig(std::string_view name, ZhoConfig &config);
+
+// The config converting back: s2t <-> t2s, s2twp <-> tw2sp, t2hk <-> hk2t ...
+constexpr ZhoConfig inverseConfig(const ZhoConfig config) {
+    constexpr ZhoConfig inverses[zho_config_count] = {
+        ZhoConfig::T2s, ZhoConfig::Tw2s, ZhoConfig::Tw2sp, ZhoConfig::Hk2s, ZhoConfig::S2t, ZhoConfig::Tw2t,
+        ZhoConfig::Tw2tp, ZhoConfig::Hk2t, ZhoConfig::S2tw, ZhoConfig::S2twp, ZhoConfig::T2tw, ZhoConfig::T2twp,
+        ZhoConfig::S2hk, ZhoConfig::T2hk, ZhoConfig::T2jp, ZhoConfig::Jp2t
+    };
+    return inverses[static_cast<int>(config)];
+}
+
+#endif // ZHOCONFIG_H
@@ -1,30 +1,142 @@
 //#include <codecvt>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <zhoutilities.h>
-#include "opencc_fmmseg_capi.h"
+#include "convertermanager.h"
 
 int ZhoCheck(const std::string &test_text) {
-    const auto opencc = opencc_new();
-    const int code = opencc_zho_check(opencc, test_text.c_str());
-    if (opencc != nullptr){
-        opencc_free(opencc);
+    const ConverterLease converter = sharedConverter();
+    return converter ? converter->check(test_text.c_str()) : 0;
+}
+
+size_t find_max_utf8_length(const std::string_view sv, size_t max_byte_count) {
+    // 1. No longer than max byte count
+    if (sv.size() <= max_byte_count) {
+        return sv.size();
+    }
+
+    // 2. Longer than byte count
+    while (max_byte_count > 0 && (sv[max_byte_count] & 0b11000000) == 0b10000000) {
+        --max_byte_count;
     }
-    return code;
+    return max_byte_count;
+}
+
+bool is_valid_utf8(const std::string_view sv) {
+    const auto *bytes = reinterpret_cast<const unsigned char *>(sv.data());
+    const size_t size = sv.size();
+    size_t i = 0;
+    while (i < size) {
+        // ASCII fast path, 8 bytes at a time
+        while (i + 8 <= size) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, sizeof(word));
+            if (word & 0x8080808080808080ULL) {
+                break;
+            }
+            i += 8;
+        }
+        if (i >= size) {
+            break;
+        }
+        const unsigned char lead = bytes[i];
+        if (lead < 0x80) {
+            ++i;
+            continue;
+        }
+        size_t length;
+        uint32_t code_point;
+        if ((lead & 0xE0) == 0xC0) {
+            length = 2;
+            code_point = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length = 3;
+            code_point = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length = 4;
+            code_point = lead & 0x07;
+        } else {
+            return false;
+        }
+        if (i + length > size) {
+            return false;
+        }
+        for (size_t k = 1; k < length; ++k) {
+            if ((bytes[i + k] & 0xC0) != 0x80) {
+                return false;
+            }
+            code_point = code_point << 6 | (bytes[i + k] & 0x3F);
+        }
+        // Overlong forms, surrogates and values beyond U+10FFFF
+        if ((length == 2 && code_point < 0x80) || (length == 3 && code_point < 0x800) ||
+            (length == 4 && code_point < 0x10000) || code_point > 0x10FFFF ||
+            (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+namespace {
+    // Characters no dictionary phrase spans: whitespace, ASCII punctuation and
+    // the CJK / full-width punctuation blocks.
+    bool is_phrase_delimiter(const std::string_view sv, const size_t pos, size_t &length) {
+        const auto lead = static_cast<unsigned char>(sv[pos]);
+        if (lead < 0x80) {
+            length = 1;
+            return lead == ' ' || lead == '\t' || lead == '\r' || lead == '\n' ||
+                   (lead >= '!' && lead <= '/') || (lead >= ':' && lead <= '@') ||
+                   (lead >= '[' && lead <= '`') || (lead >= '{' && lead <= '~');
+        }
+        if (pos + 2 >= sv.size() || (lead & 0xF0) != 0xE0) {
+            return false;
+        }
+        length = 3;
+        const auto b1 = static_cast<unsigned char>(sv[pos + 1]);
+        const auto b2 = static_cast<unsigned char>(sv[pos + 2]);
+        // U+3000..U+303F CJK Symbols and Punctuation
+        if (lead == 0xE3 && b1 == 0x80) {
+            return true;
+        }
+        // U+2010..U+203F General Punctuation (dashes, quotes, ellipsis)
+        if (lead == 0xE2 && b1 == 0x80 && b2 >= 0x90) {
+            return true;
+        }
+        // U+FF01..U+FF0F, U+FF1A..U+FF20 full-width punctuation
+        return lead == 0xEF && b1 == 0xBC && ((b2 >= 0x81 && b2 <= 0x8F) || (b2 >= 0x9A && b2 <= 0xA0));
+    }
+}
+
+size_t find_split_boundary(const std::string_view sv, const size_t max_byte_count) {
+    if (sv.size() <= max_byte_count) {
+        return sv.size();
+    }
+
+    // 1. After the last line break
+    if (const size_t newline = sv.rfind('\n', max_byte_count - 1); newline != std::string_view::npos) {
+        return newline + 1;
+    }
+
+    // 2. After the last delimiter within a short look-back window
+    constexpr size_t look_back = 4096;
+    const size_t end = find_max_utf8_length(sv, max_byte_count);
+    const size_t stop = end > look_back ? end - look_back : 0;
+    for (size_t pos = end; pos > stop;) {
+        --pos;
+        if ((sv[pos] & 0b11000000) == 0b10000000) {
+            continue;
+        }
+        if (size_t length = 0; is_phrase_delimiter(sv, pos, length) && pos + length <= end) {
+            return pos + length;
+        }
+    }
+
+    // 3. Any character boundary
+    return end;
 }
 
-//size_t find_max_utf8_length(const std::string_view sv, size_t max_byte_count) {
-//    // 1. No longer than max byte count
-//    if (sv.size() <= max_byte_count) {
-//        return sv.size();
-//    }
-//
-//    // 2. Longer than byte count
-//    while ((sv[max_byte_count] & 0b11000000) == 0b10000000) {
-//        --max_byte_count;
-//    }
-//    return max_byte_count;
-//}
-//
 //std::string convert_punctuation(std::string_view sv, std::string_view config) {
 //    std::unordered_map<std::wstring, std::wstring> s2t_punctuation_chars = {
 //            // Declare a dictionary to store the characters and their mappings
@@ -4,12 +4,19 @@
 #ifndef ZHOUTILITIES_H
 #define ZHOUTILITIES_H
 
+#include <string>
 #include <string_view>
 
 int ZhoCheck(const std::string &test_text);
 
 size_t find_max_utf8_length(std::string_view sv, size_t max_byte_count);
 
+bool is_valid_utf8(std::string_view sv);
+
+// Longest prefix of at most max_byte_count bytes that can be converted on its
+// own without cutting a character or a dictionary phrase in two.
+size_t find_split_boundary(std::string_view sv, size_t max_byte_count);
+
 std::string convert_punctuation(std::string_view sv, std::string_view config);
 
 #endif // ZHOUTILITIES_H
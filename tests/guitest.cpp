@@ -0,0 +1,65 @@
+#include <QApplication>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+#include "mainwindow.h"
+#include "guibenchmark.h"
+
+// Drives the main window through the GUI benchmark (on the offscreen
+// platform, set by the test's environment) and fails on any step over its
+// wall time, stall or resident memory budget.
+class GuiTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void stepsWithinBudgets();
+};
+
+namespace {
+    // Inputs a quarter of the benchmark's, so a loaded CI machine stays
+    // well inside the budgets
+    constexpr int text_size = 2 * 1024 * 1024;
+    constexpr int keystrokes = 100;
+    constexpr int batch_files = 500;
+    constexpr int converter_wait_msec = 60000;
+
+    constexpr double wall_budget_msec = 10000;
+    constexpr double stall_budget_msec = 1000;
+    constexpr qint64 growth_budget_bytes = 512LL * 1024 * 1024;
+}
+
+void GuiTest::initTestCase() {
+    // Settings and caches of its own, not the user's
+    QStandardPaths::setTestModeEnabled(true);
+    QApplication::setOrganizationName("laisuk");
+    QApplication::setApplicationName("ZhoConverterQt-test");
+}
+
+void GuiTest::stepsWithinBudgets() {
+    MainWindow window;
+    QSignalSpy ready(&window, &MainWindow::converterReady);
+    window.show();
+    QVERIFY2(ready.wait(converter_wait_msec), "The converter did not load");
+
+    GuiBenchmarkOptions options;
+    options.textSize = text_size;
+    options.keystrokes = keystrokes;
+    options.batchFiles = batch_files;
+    QList<GuiStepResult> steps;
+    QCOMPARE(runGuiBenchmark(window, options, &steps), 0);
+    QCOMPARE(steps.size(), 4);
+    for (const GuiStepResult &step: steps) {
+        QVERIFY2(step.wallMsec <= wall_budget_msec,
+                 qPrintable(QStringLiteral("%1: %2 ms wall time").arg(step.name).arg(step.wallMsec)));
+        QVERIFY2(step.stallMsec <= stall_budget_msec,
+                 qPrintable(QStringLiteral("%1: %2 ms stall").arg(step.name).arg(step.stallMsec)));
+        QVERIFY2(step.growthBytes <= growth_budget_bytes,
+                 qPrintable(QStringLiteral("%1: %2 bytes RSS growth").arg(step.name).arg(step.growthBytes)));
+    }
+}
+
+QTEST_MAIN(GuiTest)
+
+#include "guitest.moc"
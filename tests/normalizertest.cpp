@@ -0,0 +1,81 @@
+#include <QTest>
+#include <string>
+#include "textnormalizer.h"
+
+// Splits texts at every pair of character boundaries and checks that
+// appendNormalized() gives the same result as on the whole text.
+class NormalizerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void splitsDoNotChangeResult_data();
+
+    void splitsDoNotChangeResult();
+};
+
+namespace {
+    // Normalizes text cut at first and second as the chunked converters
+    // do: each piece into a buffer of its own
+    std::string normalizeInThree(const std::string &text, const NormalizeOptions &options, const size_t first,
+                                 const size_t second) {
+        const std::string_view pieces[] = {std::string_view(text).substr(0, first),
+                                           std::string_view(text).substr(first, second - first),
+                                           std::string_view(text).substr(second)};
+        NormalizeState state;
+        std::string out;
+        for (const std::string_view piece: pieces) {
+            std::string normalized;
+            appendNormalized(piece, options, normalized, &state);
+            out += normalized;
+        }
+        std::string rest;
+        finishNormalized(state, rest);
+        return out + rest;
+    }
+
+    bool isCharStart(const std::string &text, const size_t i) {
+        return (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80;
+    }
+}
+
+void NormalizerTest::splitsDoNotChangeResult_data() {
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<bool>("nfc");
+    QTest::addColumn<bool>("widen");
+
+    // Marks composing with the character before them, a run of marks NFC
+    // reorders, U+0338 on ASCII, kana voicing and conjoining jamo
+    QTest::newRow("nfc") << QByteArray(u8"cafe\u0301 e\u0301\u0327 x\u0301\u0327 <\u0338 \u304B\u3099\n"
+                                       u8"\u1100\u1161\u11A8 A\u030A\u0301") << true << false;
+    QTest::newRow("parentheses") << QByteArray(u8"中文(abc) 和 (中文) 中(x(y)z)，好") << false << true;
+    QTest::newRow("nfc and parentheses") << QByteArray(u8"中(e\u0301)文 (a\u0308)") << true << true;
+}
+
+void NormalizerTest::splitsDoNotChangeResult() {
+    QFETCH(QByteArray, text);
+    QFETCH(bool, nfc);
+    QFETCH(bool, widen);
+    NormalizeOptions options;
+    options.nfc = nfc;
+    options.punctuationWidth = widen ? PunctuationWidth::Full : PunctuationWidth::Keep;
+
+    const std::string input = text.toStdString();
+    std::string whole;
+    appendNormalized(input, options, whole);
+    for (size_t first = 0; first <= input.size(); ++first) {
+        for (size_t second = first; second <= input.size(); ++second) {
+            if ((first < input.size() && !isCharStart(input, first)) ||
+                (second < input.size() && !isCharStart(input, second))) {
+                continue;
+            }
+            const std::string split = normalizeInThree(input, options, first, second);
+            QVERIFY2(split == whole, qPrintable(QStringLiteral("split at %1 and %2: %3, whole: %4")
+                                                    .arg(first).arg(second).arg(QString::fromStdString(split),
+                                                                                QString::fromStdString(whole))));
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(NormalizerTest)
+
+#include "normalizertest.moc"
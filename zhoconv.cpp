@@ -0,0 +1,552 @@
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMetaEnum>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <string>
+#include "streamconverter.h"
+#include "compressedio.h"
+#include "batchconverter.h"
+#include "batchplanner.h"
+#include "iobenchmark.h"
+#include "latencybenchmark.h"
+#include "convertermanager.h"
+#include "workerpool.h"
+#include "taskscheduler.h"
+#include "cpuplacement.h"
+#include "calibration.h"
+#include "folderwatcher.h"
+#include "metricsserver.h"
+#include "textnormalizer.h"
+#include "variantbenchmark.h"
+#include "roundtripchecker.h"
+#include "differentialcheck.h"
+#include "backendbenchmark.h"
+#include "concurrencycheck.h"
+#include "resultstore.h"
+#include "resultreport.h"
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace {
+    struct FileCloser {
+        void operator()(FILE *file) const {
+            if (file != nullptr && file != stdin && file != stdout) {
+                std::fclose(file);
+            }
+        }
+    };
+
+    using FilePtr = std::unique_ptr<FILE, FileCloser>;
+
+    FilePtr openStream(const QString &path, const char *mode, FILE *standard) {
+        if (path.isEmpty() || path == "-") {
+#ifdef Q_OS_WIN
+            _setmode(_fileno(standard), _O_BINARY);
+#endif
+            return FilePtr(standard);
+        }
+#ifdef Q_OS_WIN
+        return FilePtr(_wfopen(reinterpret_cast<const wchar_t *>(path.utf16()),
+                               QString::fromLatin1(mode).toStdWString().c_str()));
+#else
+        return FilePtr(std::fopen(QFile::encodeName(path).constData(), mode));
+#endif
+    }
+
+    bool parseCompression(const QString &name, Compression &compression) {
+        if (name == "none") {
+            compression = Compression::None;
+        } else if (name == "gzip" || name == "gz") {
+            compression = Compression::Gzip;
+        } else if (name == "zstd" || name == "zst") {
+            compression = Compression::Zstd;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Converts every file into out_dir on the parallel batch engine. With
+    // estimate, the result is compared with it afterwards.
+    int runBatch(const QList<BatchConverter::Job> &jobs, const QString &out_dir, const ZhoConfig config,
+                 const bool punctuation, const BatchConverter::IoBackend io_backend, const int worker_processes,
+                 const BatchEstimate *estimate) {
+        if (!QDir().mkpath(out_dir)) {
+            std::fprintf(stderr, "zhoconv: cannot create output directory %s\n", qPrintable(out_dir));
+            return 3;
+        }
+
+        int failures = 0;
+        qint64 input_bytes = 0;
+        qint64 output_bytes = 0;
+        BatchConverter converter;
+        converter.setIoBackend(io_backend);
+        converter.setWorkerProcesses(worker_processes);
+        QEventLoop loop;
+        QObject::connect(&converter, &BatchConverter::fileFinished, &loop,
+                         [&](int, const QString &input, const QString &output, const BatchConverter::Status status) {
+                             if (status == BatchConverter::Done) {
+                                 input_bytes += QFileInfo(input).size();
+                                 output_bytes += QFileInfo(output).size();
+                             } else {
+                                 ++failures;
+                                 std::fprintf(stderr, "zhoconv: %s: %s\n", qPrintable(input),
+                                              QMetaEnum::fromType<BatchConverter::Status>().valueToKey(status));
+                             }
+                         });
+        QObject::connect(&converter, &BatchConverter::finished, &loop, &QEventLoop::quit);
+        QElapsedTimer timer;
+        timer.start();
+        converter.start(jobs, config, punctuation);
+        loop.exec();
+        const double seconds = static_cast<double>(timer.elapsed()) / 1000;
+        if (estimate != nullptr) {
+            std::printf("%s\n", qPrintable(recordBatchResult(*estimate, seconds, output_bytes)));
+        }
+        if (input_bytes > 0) {
+            appendResult("batch", "zhoconv", config, batchWorkload(jobs.size(), input_bytes),
+                         static_cast<double>(input_bytes) / 1e6 / std::max(seconds, 1e-3));
+        }
+        return failures == 0 ? 0 : 4;
+    }
+
+    // Converts files created or changed under watch_dir into the same place
+    // below out_dir, until the process is stopped.
+    int runWatch(const QString &watch_dir, const QString &out_dir, const ZhoConfig config, const bool punctuation,
+                 const BatchConverter::IoBackend io_backend, const int worker_processes) {
+        // Output inside the watched tree would be picked up as new input,
+        // converted into out/out/... and so on without end
+        if (!QDir().mkpath(out_dir)) {
+            std::fprintf(stderr, "zhoconv: cannot create output directory %s\n", qPrintable(out_dir));
+            return 3;
+        }
+        const QString watch_path = QFileInfo(watch_dir).canonicalFilePath();
+        const QString out_path = QFileInfo(out_dir).canonicalFilePath();
+        if (!watch_path.isEmpty() && (out_path == watch_path || out_path.startsWith(watch_path + "/"))) {
+            std::fprintf(stderr, "zhoconv: output directory %s is inside the watched folder\n", qPrintable(out_dir));
+            return 2;
+        }
+        FolderWatcher watcher;
+        if (!watcher.start(watch_dir)) {
+            std::fprintf(stderr, "zhoconv: cannot watch %s\n", qPrintable(watch_dir));
+            return 2;
+        }
+        BatchConverter converter;
+        converter.setIoBackend(io_backend);
+        converter.setWorkerProcesses(worker_processes);
+        QObject::connect(&converter, &BatchConverter::fileFinished, &converter,
+                         [](int, const QString &input, const QString &, const BatchConverter::Status status) {
+                             if (status != BatchConverter::Done) {
+                                 std::fprintf(stderr, "zhoconv: %s: %s\n", qPrintable(input),
+                                              QMetaEnum::fromType<BatchConverter::Status>().valueToKey(status));
+                             }
+                         });
+        QObject::connect(&watcher, &FolderWatcher::filesReady, &converter, [&](const QStringList &files) {
+            const QDir root(watcher.directory());
+            QList<BatchConverter::Job> jobs;
+            for (const QString &file_path: files) {
+                jobs.append({file_path, out_dir + "/" + root.relativeFilePath(file_path)});
+            }
+            converter.start(jobs, config, punctuation);
+        });
+        std::fprintf(stderr, "zhoconv: watching %s\n", qPrintable(watcher.directory()));
+        return QCoreApplication::exec();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("laisuk");
+    QCoreApplication::setApplicationName("zhoconv");
+    QCoreApplication::setApplicationVersion("1.0.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Chinese text converter (stdin/stdout filter by default).\n"
+        "gzip / zstd input is detected automatically.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    const QCommandLineOption config_option({"c", "config"}, "Conversion config, e.g. s2t, s2twp, t2s.",
+                                           "config", "s2t");
+    const QCommandLineOption punctuation_option({"p", "punct"}, "Convert punctuations as well.");
+    const QCommandLineOption input_option({"i", "input"}, "Input file (default: stdin).", "file");
+    const QCommandLineOption output_option({"o", "output"}, "Output file (default: stdout).", "file");
+    const QCommandLineOption block_option("block-size", "Read / convert block size in KiB.", "KiB",
+                                          QString::number(StreamConverter::default_block_size / 1024));
+    const QCommandLineOption compress_option("compress", "Output compression: none, gzip or zstd "
+                                             "(default: from output file suffix).", "method");
+    const QCommandLineOption level_option("level", "Compression level (default: library default).", "level",
+                                          "-1");
+    const QCommandLineOption out_dir_option("out-dir", "Batch mode: convert the given files into this directory.",
+                                            "dir");
+    const QCommandLineOption io_option("io", "Batch mode file I/O: standard or uring (Linux io_uring).", "backend",
+                                       "standard");
+    const QCommandLineOption workers_option("workers", "Batch mode: convert in this many isolated worker "
+                                            "processes instead of threads (0: threads).", "count", "0");
+    const QCommandLineOption watch_option("watch", "With --out-dir: convert files created or changed in this "
+                                          "directory tree until stopped.", "dir");
+    const QCommandLineOption metrics_option("metrics-port", "Batch and watch modes: serve Prometheus metrics on "
+                                            "http://localhost:<port>/metrics.", "port");
+    const QCommandLineOption dry_run_option("dry-run", "Batch mode: only print the estimated time, output size "
+                                            "and memory.");
+    const QCommandLineOption estimate_option("estimate", "Batch mode: print the estimate, then compare it with the "
+                                             "actual run.");
+    const QCommandLineOption nfc_option("nfc", "Normalize input to Unicode NFC before converting.");
+    const QCommandLineOption fold_width_option("fold-width", "Fold full-width letters and digits to ASCII and "
+                                               "half-width katakana to full width before converting.");
+    const QCommandLineOption punct_width_option("punct-width", "Punctuation width before converting: keep, full "
+                                                "(after CJK text) or half.", "width", "keep");
+    const QCommandLineOption fold_variants_option("fold-variants", "Fold variant characters to the standard forms "
+                                                  "the config's dictionaries know before converting.");
+    const QCommandLineOption variant_dir_option("variant-dir", "Per-config variant tables (<config>.txt, "
+                                                "\"variant standard\" per line) extending the built-in ones.",
+                                                "dir");
+    const QCommandLineOption backend_option("backend", "Converter backend (default: " + default_backend + ").",
+                                            "name", default_backend);
+    const QCommandLineOption threads_option("threads", "Conversion threads (0: one per CPU).", "count", "0");
+    const QCommandLineOption cpus_option("cpus", "Run only on these CPUs, e.g. 0-3,8.", "list");
+    const QCommandLineOption nice_option("nice", "Nice level of conversion threads.", "level", "0");
+    const QCommandLineOption performance_option("performance-cores", "On hybrid CPUs, keep conversion on "
+                                                "performance cores.");
+    const QCommandLineOption recalibrate_option("recalibrate", "Measure the best chunk size and thread count for "
+                                                "this host, cache and print them.");
+    QCommandLineOption worker_option("worker", "Run as a batch worker process (internal).");
+    worker_option.setFlags(QCommandLineOption::HiddenFromHelp);
+    const QCommandLineOption bench_io_option("bench-io", "Benchmark batch file I/O on a small-file corpus "
+                                             "generated in this directory.", "dir");
+    const QCommandLineOption bench_files_option("bench-files", "Number of files for --bench-io.", "count",
+                                                "1000000");
+    const QCommandLineOption bench_size_option("bench-size", "File size in bytes for --bench-io.", "bytes",
+                                               "2048");
+    const QCommandLineOption bench_no_convert_option("bench-no-convert", "Measure I/O only in --bench-io.");
+    const QCommandLineOption bench_latency_option("bench-latency", "Benchmark interactive conversion latency under "
+                                                  "batch load, on large files generated in this directory "
+                                                  "(--bench-files / --bench-size default to 32 x 8 MiB).", "dir");
+    const QCommandLineOption latency_budget_option("latency-budget", "With --bench-latency, fail when the snippet "
+                                                   "p99 under batch load with preemption is over this.", "ms");
+    const QCommandLineOption bench_cpu_option("bench-cpu", "Benchmark batch throughput and latency per thread "
+                                              "count and CPU placement, on the --bench-latency corpus.", "dir");
+    const QCommandLineOption round_trip_option("round-trip", "Convert the given files (or standard input) with the "
+                                               "config and back, and write every span that changes, with "
+                                               "frequency and context, to this report.", "report");
+    const QCommandLineOption verify_option("verify", "Check that the chunked, streamed and pipelined conversions "
+                                           "give the same bytes as whole-text conversion on this many random "
+                                           "and mutated inputs, and flag inputs converting far slower than "
+                                           "linear; failing inputs are saved to --out-dir (default: .).", "count");
+    const QCommandLineOption verify_seed_option("verify-seed", "Random seed for --verify (default: random).",
+                                                "seed", "0");
+    const QCommandLineOption stress_option("stress", "Check that the converter can be shared: convert with every "
+                                           "config from this many threads at once while the instance is "
+                                           "evicted and reloaded, comparing with single-threaded output.",
+                                           "threads");
+    const QCommandLineOption stress_seconds_option("stress-seconds", "Duration of --stress.", "seconds", "30");
+    const QCommandLineOption bench_backends_option("bench-backends", "Benchmark every registered converter "
+                                                   "backend side by side.");
+    const QCommandLineOption bench_variants_option("bench-variants", "Benchmark variant folding cost and hit rate "
+                                                   "on a variant-heavy corpus made from this clean text "
+                                                   "(\"-\": built-in sample; size from --bench-size, "
+                                                   "default 16 MiB).", "file");
+    const QCommandLineOption report_option("report", "Print the stored benchmark and batch results per series, "
+                                           "throughput and latency over time, marking shifts (store: "
+                                           "$ZHO_RESULTS or " + resultStorePath() + ").");
+    const QCommandLineOption report_kind_option("report-kind", "Only results of this kind in --report "
+                                                "(batch, bench-latency, bench-cpu, bench-io, bench-backends, "
+                                                "bench-variants).", "kind");
+    const QCommandLineOption compare_option("compare", "With --report, test two stored runs (ids as listed) "
+                                            "for a significant change.", "id,id");
+    parser.addOptions({
+        config_option, punctuation_option, input_option, output_option, block_option, compress_option, level_option,
+        out_dir_option, io_option, workers_option, watch_option, metrics_option, dry_run_option, estimate_option,
+        nfc_option, fold_width_option, punct_width_option, fold_variants_option, variant_dir_option, backend_option,
+        threads_option, cpus_option, nice_option, performance_option, recalibrate_option, worker_option,
+        bench_io_option, bench_files_option, bench_size_option, bench_no_convert_option, bench_latency_option,
+        latency_budget_option, bench_cpu_option, bench_variants_option, round_trip_option, verify_option,
+        verify_seed_option, bench_backends_option, stress_option, stress_seconds_option, report_option,
+        report_kind_option, compare_option
+    });
+    parser.addPositionalArgument("files", "Input files for batch mode (with --out-dir) or --round-trip.",
+                                 "[files...]");
+    parser.process(app);
+
+    NormalizeOptions normalize;
+    normalize.nfc = parser.isSet(nfc_option);
+    normalize.foldWidth = parser.isSet(fold_width_option);
+    if (const QString width = parser.value(punct_width_option); width == "full") {
+        normalize.punctuationWidth = PunctuationWidth::Full;
+    } else if (width == "half") {
+        normalize.punctuationWidth = PunctuationWidth::Half;
+    } else if (width != "keep") {
+        std::fprintf(stderr, "zhoconv: unknown punctuation width %s\n", qPrintable(width));
+        return 1;
+    }
+    normalize.foldVariants = parser.isSet(fold_variants_option);
+    setTextNormalization(normalize);
+    setVariantDirectory(parser.value(variant_dir_option));
+
+    if (const QString backend = parser.value(backend_option); backendNames().contains(backend)) {
+        ConverterManager::instance().setBackend(backend);
+    } else {
+        std::fprintf(stderr, "zhoconv: unknown backend %s (available: %s)\n", qPrintable(backend),
+                     qPrintable(backendNames().join(", ")));
+        return 1;
+    }
+
+    CpuPlacement placement;
+    if (!parseCpuList(parser.value(cpus_option), placement.cpus)) {
+        std::fprintf(stderr, "zhoconv: invalid CPU list %s\n", qPrintable(parser.value(cpus_option)));
+        return 1;
+    }
+    placement.nice = parser.value(nice_option).toInt();
+    placement.preferPerformanceCores = parser.isSet(performance_option);
+    // The main thread does the filter and worker conversions itself and
+    // threads it starts inherit its settings; pool threads apply the
+    // placement per priority class.
+    if (!placement.cpus.isEmpty() || placement.preferPerformanceCores) {
+        setThreadAffinity(placementCpus(placement, true));
+    }
+    if (placement.nice != 0 && !setThreadNice(placement.nice)) {
+        std::fprintf(stderr, "zhoconv: cannot set nice %d (lowest allowed: %d)\n", placement.nice,
+                     lowestThreadNice(0));
+        return 1;
+    }
+    TaskScheduler::instance().setThreadCount(parser.value(threads_option).toInt());
+    TaskScheduler::instance().setPlacement(placement);
+
+    if (parser.isSet(recalibrate_option)) {
+        const Calibration calibration = calibrate();
+        if (calibration.chunkSize == 0) {
+            std::fprintf(stderr, "zhoconv: %s\n", qPrintable(ConverterManager::instance().lastError()));
+            return 1;
+        }
+        std::fputs(qPrintable(formatCalibration(calibration)), stdout);
+        return 0;
+    }
+    // An explicit thread count wins over the calibrated one; --threads 0
+    // asks for the automatic count like leaving it out
+    const bool keep_threads = parser.value(threads_option).toInt() > 0;
+    if (const auto calibration = cachedCalibration()) {
+        applyCalibration(*calibration, keep_threads);
+    }
+
+    if (parser.isSet(worker_option)) {
+        return WorkerPool::runWorker();
+    }
+
+    ZhoConfig config;
+    if (!parseConfig(parser.value(config_option).toStdString(), config)) {
+        std::fprintf(stderr, "zhoconv: unknown config %s\n", qPrintable(parser.value(config_option)));
+        return 1;
+    }
+
+    if (parser.isSet(report_option)) {
+        ResultReportOptions options;
+        options.path = resultStorePath();
+        options.kind = parser.value(report_kind_option);
+        if (parser.isSet(compare_option)) {
+            const QStringList ids = parser.value(compare_option).split(',');
+            options.first = ids.value(0).toInt();
+            options.second = ids.value(1).toInt();
+            if (ids.size() != 2 || options.first <= 0 || options.second <= 0) {
+                std::fprintf(stderr, "zhoconv: --compare takes two result ids\n");
+                return 1;
+            }
+        }
+        return runResultReport(options);
+    }
+
+    if (parser.isSet(bench_io_option)) {
+        IoBenchmarkOptions options;
+        options.directory = parser.value(bench_io_option);
+        options.files = parser.value(bench_files_option).toInt();
+        options.fileSize = parser.value(bench_size_option).toInt();
+        options.config = config;
+        options.convert = !parser.isSet(bench_no_convert_option);
+        return runIoBenchmark(options);
+    }
+
+    if (parser.isSet(bench_latency_option)) {
+        LatencyBenchmarkOptions options;
+        options.directory = parser.value(bench_latency_option);
+        if (parser.isSet(bench_files_option)) {
+            options.files = parser.value(bench_files_option).toInt();
+        }
+        if (parser.isSet(bench_size_option)) {
+            options.fileSize = parser.value(bench_size_option).toInt();
+        }
+        if (parser.isSet(latency_budget_option)) {
+            bool ok = false;
+            options.p99BudgetMsec = parser.value(latency_budget_option).toDouble(&ok);
+            if (!ok || options.p99BudgetMsec <= 0) {
+                std::fprintf(stderr, "zhoconv: --latency-budget takes a positive number of ms\n");
+                return 1;
+            }
+        }
+        options.config = config;
+        return runLatencyBenchmark(options);
+    }
+
+    if (parser.isSet(bench_cpu_option)) {
+        LatencyBenchmarkOptions options;
+        options.directory = parser.value(bench_cpu_option);
+        if (parser.isSet(bench_files_option)) {
+            options.files = parser.value(bench_files_option).toInt();
+        }
+        if (parser.isSet(bench_size_option)) {
+            options.fileSize = parser.value(bench_size_option).toInt();
+        }
+        options.config = config;
+        return runPlacementBenchmark(options);
+    }
+
+    if (parser.isSet(stress_option)) {
+        ConcurrencyCheckOptions options;
+        options.threads = parser.value(stress_option).toInt();
+        options.seconds = parser.value(stress_seconds_option).toInt();
+        return runConcurrencyCheck(options);
+    }
+
+    if (parser.isSet(bench_backends_option)) {
+        return runBackendBenchmark(config);
+    }
+
+    if (parser.isSet(bench_variants_option)) {
+        VariantBenchmarkOptions options;
+        if (const QString file = parser.value(bench_variants_option); file != "-") {
+            options.file = file;
+        }
+        if (parser.isSet(bench_size_option)) {
+            options.size = parser.value(bench_size_option).toInt();
+        }
+        options.config = config;
+        return runVariantBenchmark(options);
+    }
+
+    if (parser.isSet(verify_option)) {
+        DifferentialCheckOptions options;
+        options.iterations = parser.value(verify_option).toInt();
+        options.seed = parser.value(verify_seed_option).toUInt();
+        if (parser.isSet(out_dir_option)) {
+            options.directory = parser.value(out_dir_option);
+        }
+        options.config = config;
+        options.punctuation = parser.isSet(punctuation_option);
+        return runDifferentialCheck(options);
+    }
+
+    if (parser.isSet(round_trip_option)) {
+        RoundTripOptions options;
+        options.files = parser.positionalArguments();
+        options.report = parser.value(round_trip_option);
+        options.config = config;
+        options.punctuation = parser.isSet(punctuation_option);
+        return runRoundTripCheck(options);
+    }
+
+    MetricsServer metrics;
+    if (parser.isSet(metrics_option)) {
+        bool ok = false;
+        const quint16 port = parser.value(metrics_option).toUShort(&ok);
+        if (!ok || port == 0) {
+            std::fprintf(stderr, "zhoconv: --metrics-port takes a port from 1 to 65535\n");
+            return 1;
+        }
+        if (!metrics.listen(port)) {
+            std::fprintf(stderr, "zhoconv: cannot serve metrics on port %u\n", port);
+            return 1;
+        }
+    }
+
+    if (parser.isSet(out_dir_option)) {
+        const QString io = parser.value(io_option);
+        if (io != "standard" && io != "uring") {
+            std::fprintf(stderr, "zhoconv: unknown I/O backend %s\n", qPrintable(io));
+            return 1;
+        }
+        const auto io_backend = io == "uring" ? BatchConverter::UringIo : BatchConverter::StandardIo;
+        if (!BatchConverter::isIoBackendAvailable(io_backend)) {
+            std::fprintf(stderr, "zhoconv: io_uring not available, using standard I/O\n");
+        }
+        if (!cachedCalibration()) {
+            std::fprintf(stderr, "zhoconv: calibrating for this host (once) ...\n");
+            applyCalibration(calibrate(), keep_threads);
+        }
+        const QString out_dir = parser.value(out_dir_option);
+        const int worker_processes = parser.value(workers_option).toInt();
+        if (parser.isSet(watch_option)) {
+            return runWatch(parser.value(watch_option), out_dir, config, parser.isSet(punctuation_option), io_backend,
+                            worker_processes);
+        }
+        QList<BatchConverter::Job> jobs;
+        for (const QString &file_path: parser.positionalArguments()) {
+            jobs.append({file_path, out_dir + "/" + QFileInfo(file_path).fileName()});
+        }
+        std::optional<BatchEstimate> estimate;
+        if (parser.isSet(dry_run_option) || parser.isSet(estimate_option)) {
+            estimate = estimateBatch(jobs, config, parser.isSet(punctuation_option),
+                                     worker_processes > 0 ? worker_processes : TaskScheduler::instance().threadCount());
+            std::printf("%s\n", qPrintable(formatEstimate(*estimate)));
+            if (parser.isSet(dry_run_option)) {
+                return 0;
+            }
+        }
+        return runBatch(jobs, out_dir, config, parser.isSet(punctuation_option), io_backend, worker_processes,
+                        estimate ? &*estimate : nullptr);
+    }
+
+    bool ok = false;
+    const size_t block_size = parser.value(block_option).toULongLong(&ok) * 1024;
+    if (!ok || block_size == 0) {
+        std::fprintf(stderr, "zhoconv: invalid block size\n");
+        return 1;
+    }
+
+    Compression compression = compressionFromName(parser.value(output_option).toStdString());
+    if (parser.isSet(compress_option) && !parseCompression(parser.value(compress_option), compression)) {
+        std::fprintf(stderr, "zhoconv: unknown compression %s\n", qPrintable(parser.value(compress_option)));
+        return 1;
+    }
+    if (!compressionAvailable(compression)) {
+        std::fprintf(stderr, "zhoconv: %s support not available in this build\n", compressionName(compression));
+        return 1;
+    }
+
+    const FilePtr input = openStream(parser.value(input_option), "rb", stdin);
+    if (!input) {
+        std::fprintf(stderr, "zhoconv: cannot open input %s\n", qPrintable(parser.value(input_option)));
+        return 2;
+    }
+    const FilePtr output = openStream(parser.value(output_option), "wb", stdout);
+    if (!output) {
+        std::fprintf(stderr, "zhoconv: cannot open output %s\n", qPrintable(parser.value(output_option)));
+        return 3;
+    }
+    std::setvbuf(output.get(), nullptr, _IOFBF, block_size);
+
+    const ConverterLease converter = sharedConverter();
+    if (!converter) {
+        std::fprintf(stderr, "zhoconv: %s\n", qPrintable(ConverterManager::instance().lastError()));
+        return 1;
+    }
+    const auto source = makeSource(input.get());
+    const auto sink = makeSink(output.get(), compression, parser.value(level_option).toInt());
+    StreamConverter stream(converter.get(), config, parser.isSet(punctuation_option),
+                           block_size);
+    std::string error;
+    const bool completed = pumpStream(*source, *sink, stream, true, error);
+
+    if (!completed) {
+        std::fprintf(stderr, "zhoconv: %s\n", error.c_str());
+        return stream.failed() ? 1 : source->failed() ? 2 : 3;
+    }
+    return 0;
+}